@@ -5,6 +5,13 @@
 #include <set>
 #include <unordered_set>
 
+extern "C" {
+#include "xhash.h"
+#include "xhash_flat.h"
+#include "xbtree.h"
+#include "xrbtree.h"
+}
+
 #define RAND_SEED   123456
 
 // random an integer
@@ -112,6 +119,248 @@ void test_set(int n)
             n, (double)(end - begin) / CLOCKS_PER_SEC, count);
 }
 
+static unsigned int_hash(void* v)
+{
+    return *(unsigned*)v;
+}
+static int int_equal(void* l, void* r)
+{
+    return *(int*)l == *(int*)r;
+}
+
+void test_hash_compare(int n)
+{
+    std::unordered_set<int> set;
+    xhash_t xh;
+    xhash_flat_t xf;
+    clock_t begin, end;
+    int value, count, i;
+
+    printf("[test xhash_t vs xhash_flat_t vs std::unordered_set<int>]\n");
+
+    xhash_init(&xh, -1, sizeof(int), int_hash, int_equal, NULL);
+    xhash_flat_init(&xf, -1, sizeof(int), int_hash, int_equal, NULL);
+
+    // insert time test, every container gets the same series number
+    srand(RAND_SEED);
+    begin = clock();
+    for (i = 0; i < n; ++i)
+    {
+        value = rand_int();
+        xhash_put(&xh, &value);
+    }
+    end = clock();
+    printf("xhash_t           insert %d random integer done, time %lfs.\n",
+            n, (double)(end - begin) / CLOCKS_PER_SEC);
+
+    srand(RAND_SEED);
+    begin = clock();
+    for (i = 0; i < n; ++i)
+    {
+        value = rand_int();
+        xhash_flat_put(&xf, &value);
+    }
+    end = clock();
+    printf("xhash_flat_t      insert %d random integer done, time %lfs.\n",
+            n, (double)(end - begin) / CLOCKS_PER_SEC);
+
+    srand(RAND_SEED);
+    begin = clock();
+    for (i = 0; i < n; ++i)
+        set.insert(rand_int());
+    end = clock();
+    printf("std::unordered_set insert %d random integer done, time %lfs.\n",
+            n, (double)(end - begin) / CLOCKS_PER_SEC);
+
+    // search time test
+    srand(RAND_SEED);
+    begin = clock();
+    for (count = 0, i = 0; i < n; ++i)
+    {
+        value = rand_int();
+        if (xhash_get(&xh, &value)) ++count;
+    }
+    end = clock();
+    printf("xhash_t           search %d random integer done, time %lfs, %d found.\n",
+            n, (double)(end - begin) / CLOCKS_PER_SEC, count);
+
+    srand(RAND_SEED);
+    begin = clock();
+    for (count = 0, i = 0; i < n; ++i)
+    {
+        value = rand_int();
+        if (xhash_flat_get(&xf, &value)) ++count;
+    }
+    end = clock();
+    printf("xhash_flat_t      search %d random integer done, time %lfs, %d found.\n",
+            n, (double)(end - begin) / CLOCKS_PER_SEC, count);
+
+    srand(RAND_SEED);
+    begin = clock();
+    for (count = 0, i = 0; i < n; ++i)
+        if (set.find(rand_int()) != set.end()) ++count;
+    end = clock();
+    printf("std::unordered_set search %d random integer done, time %lfs, %d found.\n",
+            n, (double)(end - begin) / CLOCKS_PER_SEC, count);
+
+    // remove time test
+    srand(RAND_SEED);
+    begin = clock();
+    for (count = 0, i = 0; i < n; ++i)
+    {
+        value = rand_int();
+        xhash_iter_t iter = xhash_get(&xh, &value);
+        if (iter) xhash_remove(&xh, iter);
+        else ++count;
+    }
+    end = clock();
+    printf("xhash_t           remove %d random integer done, time %lfs, %d not found.\n",
+            n, (double)(end - begin) / CLOCKS_PER_SEC, count);
+
+    srand(RAND_SEED);
+    begin = clock();
+    for (count = 0, i = 0; i < n; ++i)
+    {
+        value = rand_int();
+        xhash_flat_iter_t iter = xhash_flat_get(&xf, &value);
+        if (iter) xhash_flat_remove(&xf, iter);
+        else ++count;
+    }
+    end = clock();
+    printf("xhash_flat_t      remove %d random integer done, time %lfs, %d not found.\n",
+            n, (double)(end - begin) / CLOCKS_PER_SEC, count);
+
+    srand(RAND_SEED);
+    begin = clock();
+    for (count = 0, i = 0; i < n; ++i)
+        if (!set.erase(rand_int())) ++count;
+    end = clock();
+    printf("std::unordered_set remove %d random integer done, time %lfs, %d not found.\n",
+            n, (double)(end - begin) / CLOCKS_PER_SEC, count);
+
+    xhash_flat_destroy(&xf);
+    xhash_destroy(&xh);
+}
+
+static int int_compare(void* l, void* r)
+{
+    return *(int*)l > *(int*)r ? 1 : (*(int*)l < *(int*)r ? -1 : 0);
+}
+
+void test_tree_compare(int n)
+{
+    std::set<int> set;
+    xrbt_t rb;
+    xbtree_t bt;
+    clock_t begin, end;
+    int value, count, i;
+
+    printf("[test xrbt_t vs xbtree_t vs std::set<int>]\n");
+
+    xrbt_init(&rb, sizeof(int), int_compare, NULL);
+    xbtree_init(&bt, sizeof(int), int_compare, NULL);
+
+    // insert time test, every container gets the same series number
+    srand(RAND_SEED);
+    begin = clock();
+    for (i = 0; i < n; ++i)
+    {
+        value = rand_int();
+        xrbt_insert(&rb, &value);
+    }
+    end = clock();
+    printf("xrbt_t      insert %d random integer done, time %lfs.\n",
+            n, (double)(end - begin) / CLOCKS_PER_SEC);
+
+    srand(RAND_SEED);
+    begin = clock();
+    for (i = 0; i < n; ++i)
+    {
+        value = rand_int();
+        xbtree_insert(&bt, &value);
+    }
+    end = clock();
+    printf("xbtree_t    insert %d random integer done, time %lfs.\n",
+            n, (double)(end - begin) / CLOCKS_PER_SEC);
+
+    srand(RAND_SEED);
+    begin = clock();
+    for (i = 0; i < n; ++i)
+        set.insert(rand_int());
+    end = clock();
+    printf("std::set    insert %d random integer done, time %lfs.\n",
+            n, (double)(end - begin) / CLOCKS_PER_SEC);
+
+    // search time test
+    srand(RAND_SEED);
+    begin = clock();
+    for (count = 0, i = 0; i < n; ++i)
+    {
+        value = rand_int();
+        if (xrbt_find(&rb, &value)) ++count;
+    }
+    end = clock();
+    printf("xrbt_t      search %d random integer done, time %lfs, %d found.\n",
+            n, (double)(end - begin) / CLOCKS_PER_SEC, count);
+
+    srand(RAND_SEED);
+    begin = clock();
+    for (count = 0, i = 0; i < n; ++i)
+    {
+        value = rand_int();
+        if (xbtree_iter_valid(xbtree_find(&bt, &value))) ++count;
+    }
+    end = clock();
+    printf("xbtree_t    search %d random integer done, time %lfs, %d found.\n",
+            n, (double)(end - begin) / CLOCKS_PER_SEC, count);
+
+    srand(RAND_SEED);
+    begin = clock();
+    for (count = 0, i = 0; i < n; ++i)
+        if (set.find(rand_int()) != set.end()) ++count;
+    end = clock();
+    printf("std::set    search %d random integer done, time %lfs, %d found.\n",
+            n, (double)(end - begin) / CLOCKS_PER_SEC, count);
+
+    // remove time test
+    srand(RAND_SEED);
+    begin = clock();
+    for (count = 0, i = 0; i < n; ++i)
+    {
+        value = rand_int();
+        xrbt_iter_t iter = xrbt_find(&rb, &value);
+        if (iter) xrbt_erase(&rb, iter);
+        else ++count;
+    }
+    end = clock();
+    printf("xrbt_t      remove %d random integer done, time %lfs, %d not found.\n",
+            n, (double)(end - begin) / CLOCKS_PER_SEC, count);
+
+    srand(RAND_SEED);
+    begin = clock();
+    for (count = 0, i = 0; i < n; ++i)
+    {
+        value = rand_int();
+        xbtree_iter_t iter = xbtree_find(&bt, &value);
+        if (xbtree_iter_valid(iter)) xbtree_erase(&bt, iter);
+        else ++count;
+    }
+    end = clock();
+    printf("xbtree_t    remove %d random integer done, time %lfs, %d not found.\n",
+            n, (double)(end - begin) / CLOCKS_PER_SEC, count);
+
+    srand(RAND_SEED);
+    begin = clock();
+    for (count = 0, i = 0; i < n; ++i)
+        if (!set.erase(rand_int())) ++count;
+    end = clock();
+    printf("std::set    remove %d random integer done, time %lfs, %d not found.\n",
+            n, (double)(end - begin) / CLOCKS_PER_SEC, count);
+
+    xbtree_destroy(&bt);
+    xrbt_destroy(&rb);
+}
+
 int main(int argc, char** argv)
 {
     int type = 0;
@@ -119,7 +368,9 @@ int main(int argc, char** argv)
     printf("intput a number:\n"
             "1 - test std::list<int> sort\n"
             "2 - test std::unordered_set<int>\n"
-            "3 - test std::set<int>\n");
+            "3 - test std::set<int>\n"
+            "4 - test xhash_t vs xhash_flat_t vs std::unordered_set<int>\n"
+            "5 - test xrbt_t vs xbtree_t vs std::set<int>\n");
     if (scanf("%d", &type))
     {
         switch (type)
@@ -127,6 +378,8 @@ int main(int argc, char** argv)
         case 1: test_list_sort(5000000); break;
         case 2: test_unordered_set(5000000); break;
         case 3: test_set(5000000); break;
+        case 4: test_hash_compare(5000000); break;
+        case 5: test_tree_compare(5000000); break;
         default:
             break;
         }
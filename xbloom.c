@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "xbloom.h"
+
+#define BLOCK_BITS          (sizeof(xbloom_block_t) * 8)
+
+/* blocks are aligned to cache line */
+#if defined(_MSC_VER)
+#include <malloc.h>
+#define blocks_alloc(sz)    _aligned_malloc(sz, sizeof(xbloom_block_t))
+#define blocks_free(p)      _aligned_free(p)
+#else
+#define blocks_alloc(sz)    aligned_alloc(sizeof(xbloom_block_t), sz)
+#define blocks_free(p)      free(p)
+#endif
+
+xbloom_t* xbloom_init(xbloom_t* xb, size_t capacity, unsigned bits)
+{
+    if (bits == 0)
+        bits = XBLOOM_DEFAULT_BITS;
+
+    xb->capacity    = capacity;
+    xb->bits        = bits;
+    xb->nblocks     = (capacity * bits + BLOCK_BITS - 1) / BLOCK_BITS;
+
+    if (xb->nblocks == 0)
+        xb->nblocks = 1;
+
+    xb->blocks      = blocks_alloc(xb->nblocks * sizeof(xbloom_block_t));
+
+    if (xb->blocks)
+    {
+        xbloom_clear(xb);
+        return xb;
+    }
+
+    return NULL;
+}
+
+void xbloom_destroy(xbloom_t* xb)
+{
+    blocks_free(xb->blocks);
+}
+
+xbloom_t* xbloom_new(size_t capacity, unsigned bits)
+{
+    xbloom_t* xb = malloc(sizeof(xbloom_t));
+
+    if (xb)
+    {
+        if (xbloom_init(xb, capacity, bits))
+            return xb;
+        free(xb);
+    }
+
+    return NULL;
+}
+
+void xbloom_free(xbloom_t* xb)
+{
+    if (xb)
+    {
+        xbloom_destroy(xb);
+        free(xb);
+    }
+}
+
+void xbloom_clear(xbloom_t* xb)
+{
+    memset(xb->blocks, 0, xb->nblocks * sizeof(xbloom_block_t));
+}
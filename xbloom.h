@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#ifndef _XBLOOM_H_
+#define _XBLOOM_H_
+
+#include <stddef.h>
+
+/*
+ * blocked bloom filter. every element lives in one block of 64 bytes (one
+ * cache line), one bit is set in each of the 8 words of the block, so that
+ * a query costs one cache access. elements are added by their hash codes
+ * (e.g. 'xhash_hash32'), they can't be removed.
+ *
+ * false positive rate depends on the bits per element, see 'xbloom_test.c'
+ * (8 bits is ~3%, 10 is ~1%, 16 is ~0.1%). elements with the same hash code
+ * can't be told apart, with 32-bit hash codes of 'n' distinct elements, the
+ * rate is at least 'n / 2^32'.
+ */
+
+#ifndef XBLOOM_DEFAULT_BITS
+#define XBLOOM_DEFAULT_BITS     10 // bits per element
+#endif
+
+#define XBLOOM_BLOCK_WORDS      8
+
+typedef struct xbloom       xbloom_t;
+typedef struct xbloom_block xbloom_block_t;
+
+struct xbloom_block
+{
+    unsigned long long  words[XBLOOM_BLOCK_WORDS];
+};
+
+struct xbloom
+{
+    size_t              capacity;   // elements it's sized for
+    size_t              nblocks;
+    unsigned            bits;       // bits per element
+    xbloom_block_t*     blocks;     // aligned to 64
+};
+
+/* initialize a 'xbloom_t' for 'capacity' elements with 'bits' bits per
+ * element, 'bits' can be 0 (means default). */
+xbloom_t* xbloom_init(xbloom_t* xb, size_t capacity, unsigned bits);
+/* destroy a 'xbloom_t' which has called 'xbloom_init'. */
+void xbloom_destroy(xbloom_t* xb);
+
+/* allocate memory and initialize a 'xbloom_t'. */
+xbloom_t* xbloom_new(size_t capacity, unsigned bits);
+/* release memory for a 'xbloom_t' which 'xbloom_new' returns. */
+void xbloom_free(xbloom_t* xb);
+
+/* remove all elements. */
+void xbloom_clear(xbloom_t* xb);
+
+/* return the number of elements which 'xb' is sized for. */
+#define xbloom_capacity(xb)     ((xb)->capacity)
+/* return the bytes of all blocks. */
+#define xbloom_memory(xb)       ((xb)->nblocks * sizeof(xbloom_block_t))
+
+/* hash codes of hash tables are often weak in high bits (e.g. identity of
+ * integers), mix all bits before picking the block and the bits. */
+static inline unsigned xbloom_mix(unsigned hash)
+{
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bU;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35U;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+/* the block of mixed 'hash', picked by multiply-shift (so the block count
+ * doesn't need to be 2^n). */
+static inline xbloom_block_t* xbloom_block_of(const xbloom_t* xb, unsigned hash)
+{
+    return &xb->blocks[(size_t)(((unsigned long long)hash * xb->nblocks) >> 32)];
+}
+
+/* the bit of mixed 'hash' in word 'i', every word has its own odd
+ * multiplier, the top 6 bits of the product depend on all bits of 'hash'. */
+static inline unsigned long long xbloom_bit(unsigned hash, int i)
+{
+    static const unsigned salts[XBLOOM_BLOCK_WORDS] =
+    {
+        0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+        0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+    };
+
+    return 1ULL << ((hash * salts[i]) >> 26);
+}
+
+/* add an element by its hash code. */
+static inline void xbloom_add(xbloom_t* xb, unsigned hash)
+{
+    xbloom_block_t* b;
+    int i;
+
+    hash = xbloom_mix(hash);
+    b = xbloom_block_of(xb, hash);
+
+    for (i = 0; i < XBLOOM_BLOCK_WORDS; ++i)
+        b->words[i] |= xbloom_bit(hash, i);
+}
+
+/* return 0 if the element of 'hash' is definitely not added, otherwise
+ * it may be added. */
+static inline int xbloom_may_contain(const xbloom_t* xb, unsigned hash)
+{
+    const xbloom_block_t* b;
+    unsigned long long miss = 0;
+    int i;
+
+    hash = xbloom_mix(hash);
+    b = xbloom_block_of(xb, hash);
+
+    /* no early exit, the words are in one cache line */
+    for (i = 0; i < XBLOOM_BLOCK_WORDS; ++i)
+        miss |= ~b->words[i] & xbloom_bit(hash, i);
+
+    return miss == 0;
+}
+
+#endif // _XBLOOM_H_
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "xbloom.h"
+#include "xhash.h"
+
+void test()
+{
+    xbloom_t* xb = xbloom_new(100, 0);
+    const char* words[] = { "apple", "banana", "cherry", "grape", "lemon" };
+    int i;
+
+    for (i = 0; i < 3; ++i)
+        xbloom_add(xb, xhash_hash32(words[i], strlen(words[i]), 0));
+
+    // "grape" and "lemon" are not added, they are very likely reported absent
+    for (i = 0; i < 5; ++i)
+        printf("%s: %s\n", words[i],
+            xbloom_may_contain(xb, xhash_hash32(words[i], strlen(words[i]), 0))
+                ? "maybe" : "no");
+
+    printf("capacity %u, memory %u bytes\n",
+        (unsigned)xbloom_capacity(xb), (unsigned)xbloom_memory(xb));
+
+    xbloom_free(xb);
+}
+
+/* ------------------------------------- */
+
+static double elapsed(struct timespec* b, struct timespec* e)
+{
+    return (e->tv_sec - b->tv_sec) + (e->tv_nsec - b->tv_nsec) / 1e9;
+}
+
+// add 'nvalues' keys, query 'nvalues' other keys with different bits per
+// element, report false positive rate and throughput. the hash codes are
+// distinct (multiplying by an odd number is a bijection).
+#define key_hash(i)     ((unsigned)(i) * 2654435761u)
+void test_speed(int nvalues)
+{
+    static const unsigned bits[] = { 6, 8, 10, 12, 16 };
+    struct timespec b, e;
+    double add, query;
+    xbloom_t xb;
+    size_t fp;
+    unsigned i, j;
+
+    for (j = 0; j < sizeof(bits) / sizeof(bits[0]); ++j)
+    {
+        xbloom_init(&xb, nvalues, bits[j]);
+
+        // keys [0, nvalues) are added, [nvalues, 2 * nvalues) are not
+        timespec_get(&b, TIME_UTC);
+        for (i = 0; i < (unsigned)nvalues; ++i)
+            xbloom_add(&xb, key_hash(i));
+        timespec_get(&e, TIME_UTC);
+        add = elapsed(&b, &e);
+
+        for (i = 0; i < (unsigned)nvalues; ++i)
+        {
+            if (!xbloom_may_contain(&xb, key_hash(i)))
+            {
+                printf("false negative!\n");
+                break;
+            }
+        }
+
+        timespec_get(&b, TIME_UTC);
+        for (fp = 0, i = nvalues; i < 2 * (unsigned)nvalues; ++i)
+            fp += xbloom_may_contain(&xb, key_hash(i));
+        timespec_get(&e, TIME_UTC);
+        query = elapsed(&b, &e);
+
+        printf("[%2u bits] memory %uKB, add %.1lf Mops/s, query %.1lf Mops/s, "
+            "false positive %.3lf%%.\n", bits[j],
+            (unsigned)(xbloom_memory(&xb) >> 10), nvalues / add / 1e6,
+            nvalues / query / 1e6, fp * 100.0 / nvalues);
+
+        xbloom_destroy(&xb);
+    }
+}
+
+/* ------------------------------------- */
+
+int main(int argc, char** argv)
+{
+    // test();
+    test_speed(10000000);
+    return 0;
+}
@@ -0,0 +1,513 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "xbtree.h"
+
+#define MIN_CAP             3 // so that 'cap / 2' >= 1
+#define MAX_DEPTH           64 // every node has 2 children at least
+
+#define node_data(bt, n, i) \
+            ((char*)((n) + 1) + (size_t)(i) * (bt)->data_size)
+#define node_children(bt, n) \
+            ((xbtree_node_t**)((char*)(n) + (bt)->child_off))
+#define node_min(bt)        ((bt)->cap / 2)
+
+static xbtree_node_t* node_alloc(xbtree_t* bt, int leaf)
+{
+    /* a leaf has no children */
+    xbtree_node_t* n = malloc(leaf ? bt->child_off
+                : bt->child_off + sizeof(xbtree_node_t*) * (bt->cap + 2));
+
+    if (n)
+    {
+        n->count = 0;
+        n->leaf = leaf;
+    }
+
+    return n;
+}
+
+/* return the first position whose element is not less than 'pdata',
+ * '*equal' is set if the element there equals to it. */
+static unsigned node_search(xbtree_t* bt, xbtree_node_t* n,
+                const void* pdata, int* equal)
+{
+    unsigned lo = 0, hi = n->count, mid;
+    int r;
+
+    while (lo < hi)
+    {
+        mid = (lo + hi) >> 1;
+        r = bt->compare_cb(node_data(bt, n, mid), (void*)pdata);
+
+        if (r < 0)
+            lo = mid + 1;
+        else if (r > 0)
+            hi = mid;
+        else
+        {
+            *equal = 1;
+            return mid;
+        }
+    }
+
+    *equal = 0;
+    return lo;
+}
+
+/* return the position of child 'n' in its parent. */
+static unsigned child_index(xbtree_t* bt, xbtree_node_t* n)
+{
+    xbtree_node_t** children = node_children(bt, n->parent);
+    unsigned i = 0;
+
+    while (children[i] != n)
+        ++i;
+
+    return i;
+}
+
+/* set the parent of children [from, to) of 'n'. */
+static void children_adopt(xbtree_t* bt, xbtree_node_t* n,
+                unsigned from, unsigned to)
+{
+    xbtree_node_t** children = node_children(bt, n);
+
+    for (; from < to; ++from)
+        children[from]->parent = n;
+}
+
+static xbtree_iter_t iter_make(xbtree_node_t* node, unsigned pos)
+{
+    xbtree_iter_t iter;
+
+    iter.node = node;
+    iter.pos = pos;
+    return iter;
+}
+
+/* split 'n' which has 'cap + 1' elements into 'n' and 'r', the middle one
+ * goes up into the parent ('p' becomes the new root if 'n' is the root).
+ * the inserted element at '*e' is tracked. */
+static void node_split(xbtree_t* bt, xbtree_node_t* n,
+                xbtree_node_t* r, xbtree_node_t* p, xbtree_iter_t* e)
+{
+    unsigned mid = n->count / 2;
+    unsigned i;
+
+    if (!n->parent)
+    {
+        p->parent = NULL;
+        node_children(bt, p)[0] = n;
+        n->parent = p;
+        bt->root = p;
+        i = 0;
+    }
+    else
+    {
+        p = n->parent;
+        i = child_index(bt, n);
+    }
+
+    /* right half */
+    r->count = n->count - mid - 1;
+    r->parent = p;
+    memcpy(node_data(bt, r, 0), node_data(bt, n, mid + 1),
+        r->count * bt->data_size);
+
+    if (!n->leaf)
+    {
+        memcpy(node_children(bt, r), node_children(bt, n) + mid + 1,
+            sizeof(xbtree_node_t*) * (r->count + 1));
+        children_adopt(bt, r, 0, r->count + 1);
+    }
+
+    /* the middle one goes to 'p' at 'i', 'r' is child 'i + 1' */
+    memmove(node_data(bt, p, i + 1), node_data(bt, p, i),
+        (p->count - i) * bt->data_size);
+    memcpy(node_data(bt, p, i), node_data(bt, n, mid), bt->data_size);
+    memmove(node_children(bt, p) + i + 2, node_children(bt, p) + i + 1,
+        sizeof(xbtree_node_t*) * (p->count - i));
+    node_children(bt, p)[i + 1] = r;
+    ++p->count;
+    n->count = mid;
+
+    if (e->node == n)
+    {
+        if (e->pos == mid)
+            *e = iter_make(p, i);
+        else if (e->pos > mid)
+            *e = iter_make(r, e->pos - mid - 1);
+    }
+    else if (e->node == p && e->pos >= i)
+    {
+        ++e->pos;
+    }
+}
+
+xbtree_t* xbtree_init(xbtree_t* bt, size_t data_size,
+            xbtree_compare_cb compare_cb, xbtree_destroy_cb destroy_cb)
+{
+    size_t off;
+
+    bt->compare_cb  = compare_cb;
+    bt->destroy_cb  = destroy_cb;
+    bt->data_size   = data_size;
+    bt->size        = 0;
+    bt->root        = NULL;
+    bt->cap         = (unsigned)((XBTREE_NODE_SIZE - sizeof(xbtree_node_t)) / data_size);
+
+    if (bt->cap < MIN_CAP)
+        bt->cap = MIN_CAP;
+
+    /* one more element for splitting, children are aligned to pointer */
+    off = sizeof(xbtree_node_t) + (bt->cap + 1) * data_size;
+    bt->child_off = (off + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+
+    return bt;
+}
+
+void xbtree_destroy(xbtree_t* bt)
+{
+    xbtree_clear(bt);
+}
+
+xbtree_t* xbtree_new(size_t data_size, xbtree_compare_cb compare_cb,
+            xbtree_destroy_cb destroy_cb)
+{
+    xbtree_t* bt = malloc(sizeof(xbtree_t));
+
+    if (bt)
+        xbtree_init(bt, data_size, compare_cb, destroy_cb);
+
+    return bt;
+}
+
+void xbtree_free(xbtree_t* bt)
+{
+    if (bt)
+    {
+        xbtree_clear(bt);
+        free(bt);
+    }
+}
+
+xbtree_iter_t xbtree_insert_ex(xbtree_t* bt, const void* pdata, size_t ksz)
+{
+    xbtree_node_t* spare[MAX_DEPTH + 1];
+    xbtree_node_t* n = bt->root;
+    xbtree_iter_t e;
+    unsigned pos;
+    int equal, need, i;
+
+    if (!n)
+    {
+        n = node_alloc(bt, 1);
+        if (!n)
+            return iter_make(NULL, 0);
+
+        n->parent = NULL;
+        bt->root = n;
+    }
+
+    for (;;)
+    {
+        pos = node_search(bt, n, pdata, &equal);
+
+        if (equal)
+            return iter_make(n, pos);
+        if (n->leaf)
+            break;
+
+        n = node_children(bt, n)[pos];
+    }
+
+    /* allocate the nodes of all splits first, so that a failed allocation
+     * leaves the tree untouched. every full node on the way up splits,
+     * plus a new root if the root splits. */
+    for (need = 0, e.node = n; e.node && e.node->count == bt->cap;
+            e.node = e.node->parent)
+        ++need;
+    if (need && !e.node)
+        ++need;
+
+    for (i = 0; i < need; ++i)
+    {
+        spare[i] = node_alloc(bt, i == 0 && n->leaf);
+        if (!spare[i])
+        {
+            while (i > 0)
+                free(spare[--i]);
+            return iter_make(NULL, 0);
+        }
+    }
+
+    memmove(node_data(bt, n, pos + 1), node_data(bt, n, pos),
+        (n->count - pos) * bt->data_size);
+    memcpy(node_data(bt, n, pos), pdata, ksz);
+    ++n->count;
+    ++bt->size;
+
+    e = iter_make(n, pos);
+
+    for (i = 0; n->count > bt->cap; ++i)
+    {
+        node_split(bt, n, spare[i], spare[i + 1 < need ? i + 1 : i], &e);
+        n = n->parent;
+    }
+
+    return e;
+}
+
+xbtree_iter_t xbtree_find(xbtree_t* bt, const void* pdata)
+{
+    xbtree_node_t* n = bt->root;
+    unsigned pos;
+    int equal;
+
+    while (n)
+    {
+        pos = node_search(bt, n, pdata, &equal);
+
+        if (equal)
+            return iter_make(n, pos);
+        if (n->leaf)
+            break;
+
+        n = node_children(bt, n)[pos];
+    }
+
+    return iter_make(NULL, 0);
+}
+
+/* merge child 'i + 1' of 'p' and the element 'i' into child 'i'. */
+static void node_merge(xbtree_t* bt, xbtree_node_t* p, unsigned i)
+{
+    xbtree_node_t* l = node_children(bt, p)[i];
+    xbtree_node_t* r = node_children(bt, p)[i + 1];
+
+    memcpy(node_data(bt, l, l->count), node_data(bt, p, i), bt->data_size);
+    memcpy(node_data(bt, l, l->count + 1), node_data(bt, r, 0),
+        r->count * bt->data_size);
+
+    if (!l->leaf)
+    {
+        memcpy(node_children(bt, l) + l->count + 1, node_children(bt, r),
+            sizeof(xbtree_node_t*) * (r->count + 1));
+        children_adopt(bt, l, l->count + 1, l->count + r->count + 2);
+    }
+
+    l->count += r->count + 1;
+    free(r);
+
+    memmove(node_data(bt, p, i), node_data(bt, p, i + 1),
+        (p->count - i - 1) * bt->data_size);
+    memmove(node_children(bt, p) + i + 1, node_children(bt, p) + i + 2,
+        sizeof(xbtree_node_t*) * (p->count - i - 1));
+    --p->count;
+}
+
+/* 'n' has less than min elements, borrow one from a sibling through the
+ * parent, or merge it with a sibling. return the parent if it may be short. */
+static xbtree_node_t* node_fix(xbtree_t* bt, xbtree_node_t* n)
+{
+    xbtree_node_t* p = n->parent;
+    xbtree_node_t* s;
+    unsigned i = child_index(bt, n);
+
+    /* borrow from the left sibling */
+    if (i > 0 && (s = node_children(bt, p)[i - 1])->count > node_min(bt))
+    {
+        memmove(node_data(bt, n, 1), node_data(bt, n, 0), n->count * bt->data_size);
+        memcpy(node_data(bt, n, 0), node_data(bt, p, i - 1), bt->data_size);
+        memcpy(node_data(bt, p, i - 1), node_data(bt, s, s->count - 1), bt->data_size);
+
+        if (!n->leaf)
+        {
+            memmove(node_children(bt, n) + 1, node_children(bt, n),
+                sizeof(xbtree_node_t*) * (n->count + 1));
+            node_children(bt, n)[0] = node_children(bt, s)[s->count];
+            node_children(bt, n)[0]->parent = n;
+        }
+
+        --s->count;
+        ++n->count;
+        return NULL;
+    }
+
+    /* borrow from the right sibling */
+    if (i < p->count && (s = node_children(bt, p)[i + 1])->count > node_min(bt))
+    {
+        memcpy(node_data(bt, n, n->count), node_data(bt, p, i), bt->data_size);
+        memcpy(node_data(bt, p, i), node_data(bt, s, 0), bt->data_size);
+        memmove(node_data(bt, s, 0), node_data(bt, s, 1),
+            (s->count - 1) * bt->data_size);
+
+        if (!n->leaf)
+        {
+            node_children(bt, n)[n->count + 1] = node_children(bt, s)[0];
+            node_children(bt, n)[n->count + 1]->parent = n;
+            memmove(node_children(bt, s), node_children(bt, s) + 1,
+                sizeof(xbtree_node_t*) * s->count);
+        }
+
+        --s->count;
+        ++n->count;
+        return NULL;
+    }
+
+    node_merge(bt, p, i > 0 ? i - 1 : i);
+    return p;
+}
+
+void xbtree_erase(xbtree_t* bt, xbtree_iter_t iter)
+{
+    xbtree_node_t* n = iter.node;
+    xbtree_node_t* l;
+
+    if (bt->destroy_cb)
+        bt->destroy_cb(xbtree_iter_data(bt, iter));
+
+    if (n->leaf)
+    {
+        memmove(node_data(bt, n, iter.pos), node_data(bt, n, iter.pos + 1),
+            (n->count - iter.pos - 1) * bt->data_size);
+    }
+    else
+    {
+        /* replaced by the predecessor, which is the last one of a leaf */
+        l = node_children(bt, n)[iter.pos];
+        while (!l->leaf)
+            l = node_children(bt, l)[l->count];
+
+        memcpy(node_data(bt, n, iter.pos), node_data(bt, l, l->count - 1),
+            bt->data_size);
+        n = l;
+    }
+
+    --n->count;
+    --bt->size;
+
+    while (n && n != bt->root && n->count < node_min(bt))
+        n = node_fix(bt, n);
+
+    /* the root is empty, the tree becomes lower */
+    n = bt->root;
+    if (n->count == 0)
+    {
+        bt->root = n->leaf ? NULL : node_children(bt, n)[0];
+        if (bt->root)
+            bt->root->parent = NULL;
+        free(n);
+    }
+}
+
+static void node_clear(xbtree_t* bt, xbtree_node_t* n)
+{
+    unsigned i;
+
+    if (!n->leaf)
+    {
+        for (i = 0; i <= n->count; ++i)
+            node_clear(bt, node_children(bt, n)[i]);
+    }
+
+    if (bt->destroy_cb)
+    {
+        for (i = 0; i < n->count; ++i)
+            bt->destroy_cb(node_data(bt, n, i));
+    }
+
+    free(n);
+}
+
+void xbtree_clear(xbtree_t* bt)
+{
+    if (bt->root)
+    {
+        node_clear(bt, bt->root);
+        bt->root = NULL;
+        bt->size = 0;
+    }
+}
+
+/* the first element of the subtree 'n'. */
+static xbtree_iter_t subtree_first(xbtree_t* bt, xbtree_node_t* n)
+{
+    while (!n->leaf)
+        n = node_children(bt, n)[0];
+
+    return iter_make(n, 0);
+}
+
+/* the last element of the subtree 'n'. */
+static xbtree_iter_t subtree_last(xbtree_t* bt, xbtree_node_t* n)
+{
+    while (!n->leaf)
+        n = node_children(bt, n)[n->count];
+
+    return iter_make(n, n->count - 1);
+}
+
+xbtree_iter_t xbtree_begin(xbtree_t* bt)
+{
+    return bt->root ? subtree_last(bt, bt->root) : iter_make(NULL, 0);
+}
+
+xbtree_iter_t xbtree_iter_next(xbtree_t* bt, xbtree_iter_t iter)
+{
+    xbtree_node_t* n = iter.node;
+    unsigned i;
+
+    if (!n->leaf)
+        return subtree_last(bt, node_children(bt, n)[iter.pos]);
+
+    if (iter.pos > 0)
+        return iter_make(n, iter.pos - 1);
+
+    /* go up until coming from a right side */
+    while (n->parent)
+    {
+        i = child_index(bt, n);
+        n = n->parent;
+
+        if (i > 0)
+            return iter_make(n, i - 1);
+    }
+
+    return iter_make(NULL, 0);
+}
+
+xbtree_iter_t xbtree_rbegin(xbtree_t* bt)
+{
+    return bt->root ? subtree_first(bt, bt->root) : iter_make(NULL, 0);
+}
+
+xbtree_iter_t xbtree_riter_next(xbtree_t* bt, xbtree_iter_t iter)
+{
+    xbtree_node_t* n = iter.node;
+    unsigned i;
+
+    if (!n->leaf)
+        return subtree_first(bt, node_children(bt, n)[iter.pos + 1]);
+
+    if (iter.pos + 1 < n->count)
+        return iter_make(n, iter.pos + 1);
+
+    /* go up until coming from a left side */
+    while (n->parent)
+    {
+        i = child_index(bt, n);
+        n = n->parent;
+
+        if (i < n->count)
+            return iter_make(n, i);
+    }
+
+    return iter_make(NULL, 0);
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#ifndef _XBTREE_H_
+#define _XBTREE_H_
+
+#include <stddef.h>
+
+/*
+ * B-tree ordered container, the same compare/destroy contract as 'xrbt_t'.
+ * every node packs up to 'cap' elements into about 'XBTREE_NODE_SIZE' bytes,
+ * so that a lookup visits log_cap(n) nodes instead of 2 * log2(n) scattered
+ * red-black nodes. elements in a node are found by binary search (it's
+ * log2(cap) calls of 'compare_cb').
+ *
+ * elements move between nodes when inserting and erasing, so an iterator
+ * (and the data pointer of it) is invalid after the tree is modified.
+ */
+
+#ifndef XBTREE_NODE_SIZE
+#define XBTREE_NODE_SIZE    512 // bytes, node header + elements
+#endif
+
+typedef struct xbtree       xbtree_t;
+typedef struct xbtree_node  xbtree_node_t;
+typedef struct xbtree_iter  xbtree_iter_t;
+
+typedef void (*xbtree_destroy_cb)(void* pdata);
+typedef int  (*xbtree_compare_cb)(void* l, void* r);
+
+struct xbtree_node
+{
+    xbtree_node_t*      parent;
+    unsigned            count;      // elements in this node
+    unsigned            leaf;
+    // char data[(cap + 1) * data_size];
+    // xbtree_node_t* children[cap + 2]; (not leaf, at 'child_off')
+};
+
+struct xbtree_iter
+{
+    xbtree_node_t*      node;       // 'NULL' means end
+    unsigned            pos;
+};
+
+struct xbtree
+{
+    xbtree_compare_cb   compare_cb;
+    xbtree_destroy_cb   destroy_cb;
+    size_t              data_size;
+    size_t              size;
+    unsigned            cap;        // max elements per node, 'cap / 2' is min
+    size_t              child_off;  // offset of children in a node
+    xbtree_node_t*      root;       // 'NULL' when empty
+};
+
+/* initialize a 'xbtree_t'.
+ * 'compare_cb' is called when comparing two datas, can't be 'NULL'.
+ * 'destroy_cb' is called when destroying an element, can be 'NULL'. */
+xbtree_t* xbtree_init(xbtree_t* bt, size_t data_size,
+            xbtree_compare_cb compare_cb, xbtree_destroy_cb destroy_cb);
+/* destroy a 'xbtree_t' which has called 'xbtree_init'. */
+void xbtree_destroy(xbtree_t* bt);
+
+/* allocate memory for a 'xbtree_t' and initialize it. */
+xbtree_t* xbtree_new(size_t data_size, xbtree_compare_cb compare_cb,
+            xbtree_destroy_cb destroy_cb);
+/* release memory for a 'xbtree_t' which 'xbtree_new' returns. */
+void xbtree_free(xbtree_t* bt);
+
+/* return the number of elements. */
+#define xbtree_size(bt)         ((bt)->size)
+/* check whether the container is empty. */
+#define xbtree_empty(bt)        ((bt)->size == 0)
+
+/* elements are iterated from the greatest to the least by 'compare_cb', the
+ * same order as 'xrbt_t', reverse iterators go from the least. */
+
+/* return an iterator to the beginning. */
+xbtree_iter_t xbtree_begin(xbtree_t* bt);
+/* return the next iterator of 'iter'. */
+xbtree_iter_t xbtree_iter_next(xbtree_t* bt, xbtree_iter_t iter);
+/* return a reverse iterator to the beginning. */
+xbtree_iter_t xbtree_rbegin(xbtree_t* bt);
+/* return the next reverse iterator of 'iter'. */
+xbtree_iter_t xbtree_riter_next(xbtree_t* bt, xbtree_iter_t iter);
+
+/* check whether an iterator is valid (not the end). */
+#define xbtree_iter_valid(iter) ((iter).node != NULL)
+/* return a pointer pointed to the data of 'iter', 'iter' MUST be valid. */
+#define xbtree_iter_data(bt, iter) \
+            ((void*)((char*)((iter).node + 1) + (iter).pos * (bt)->data_size))
+
+/* insert an element with specific data, return an iterator to the
+ * inserted element, return an invalid iterator when out of memory.
+ * if the data is already exist, do nothing an return it's iterator. */
+#define xbtree_insert(bt, pdata) \
+            xbtree_insert_ex(bt, pdata, (bt)->data_size)
+/* similar to 'xbtree_insert', but useful when we don't want to init all 'data_size',
+ * just init the <key> (which size is 'ksz'), and set <value> by yourself later. */
+xbtree_iter_t xbtree_insert_ex(xbtree_t* bt, const void* pdata, size_t ksz);
+/* find an element with specific data. return an iterator to the element
+ * with specific data, return an invalid iterator if not found. */
+xbtree_iter_t xbtree_find(xbtree_t* bt, const void* pdata);
+/* remove an element at 'iter', 'iter' MUST be valid. */
+void xbtree_erase(xbtree_t* bt, xbtree_iter_t iter);
+/* remove all elements in 'bt'. */
+void xbtree_clear(xbtree_t* bt);
+
+#endif // _XBTREE_H_
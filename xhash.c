@@ -5,9 +5,547 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "xhash.h"
 
+#if XHASH_ENABLE_THREADS
+#include <pthread.h>
+#endif
+
+#if defined(__GNUC__)
+#define xhash_prefetch(p)   __builtin_prefetch(p)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define xhash_prefetch(p)   _mm_prefetch((const char*)(p), _MM_HINT_T0)
+#else
+#define xhash_prefetch(p)   ((void)0)
+#endif
+
+#if XHASH_ENABLE_STATS
+/* puts, resizes and cache hits are counted by writers only. */
+#define stats_add(xh, f, n)     ((xh)->stats.f += (n))
+
+/* lookups may run in parallel (readers of 'xhash_concurrent_t' share a
+ * read lock), their counters are updated atomically. */
+#if defined(__GNUC__)
+#define stats_atomic_add(p, n)  __atomic_fetch_add(p, n, __ATOMIC_RELAXED)
+#define stats_atomic_load(p)    __atomic_load_n(p, __ATOMIC_RELAXED)
+#define stats_atomic_cas(p, o, n) \
+            __atomic_compare_exchange_n(p, &(o), n, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define stats_atomic_add(p, n) \
+            _InterlockedExchangeAdd64((volatile long long*)(p), (long long)(n))
+#define stats_atomic_load(p)    (*(volatile unsigned long long*)(p))
+#define stats_atomic_cas(p, o, n) \
+            ((unsigned long long)_InterlockedCompareExchange64((volatile long long*) \
+                (p), (long long)(n), (long long)(o)) == (o) ? 1 : ((o) = *(p), 0))
+#else
+#define stats_atomic_add(p, n)  (*(p) += (n)) /* approximate */
+#define stats_atomic_load(p)    (*(p))
+#define stats_atomic_cas(p, o, n) (*(p) = (n), 1)
+#endif
+
+/* a lookup visited 'probes' nodes, 'found' or not. */
+static inline void stats_lookup(xhash_t* xh, size_t probes, int found)
+{
+    unsigned long long max;
+
+    if (found)
+        stats_atomic_add(&xh->stats.hits, 1);
+    else
+        stats_atomic_add(&xh->stats.misses, 1);
+
+    stats_atomic_add(&xh->stats.probes, probes);
+
+    /* 'max' is reloaded when it's changed by others */
+    max = stats_atomic_load(&xh->stats.max_probe);
+    while (probes > max && !stats_atomic_cas(&xh->stats.max_probe, max, probes))
+        ;
+}
+
+static inline unsigned long long stats_now(void)
+{
+    struct timespec ts;
+
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* buckets are resized successfully, it began at 'begin'. */
+static inline void stats_resized(xhash_t* xh, unsigned long long begin)
+{
+    ++xh->stats.resizes;
+    xh->stats.resize_ns += stats_now() - begin;
+}
+#else
+#define stats_add(xh, f, n)             ((void)0)
+#define stats_lookup(xh, probes, found) ((void)(probes))
+#endif
+
+/* nodes in the block of 'xhash_build' are not freed one by one. */
+#define bulk_has(xh, node) \
+            ((size_t)(node) - (size_t)(xh)->bulk < (xh)->bulk_size)
+
+static inline void bulk_free(xhash_t* xh)
+{
+    free(xh->bulk);
+    xh->bulk = NULL;
+    xh->bulk_size = 0;
+}
+
+#if XHASH_ENABLE_BLOOM
+/* drop the filter being filled by migration. */
+static inline void bloom_next_free(xhash_t* xh)
+{
+#if XHASH_ENABLE_INCREMENTAL
+    xbloom_destroy(&xh->bloom_next);
+    xh->bloom_next.blocks = NULL;
+#endif
+}
+
+/* refill the prefilter with all elements, it's sized for the buckets. */
+static void bloom_rebuild(xhash_t* xh)
+{
+    size_t cap = xh->bkt_size * xh->loadfactor / 100;
+    xhash_iter_t iter;
+
+    /* all elements are added below */
+    bloom_next_free(xh);
+
+    if (cap < xh->size)
+        cap = xh->size;
+
+    if (cap != xh->bloom.capacity)
+    {
+        xbloom_destroy(&xh->bloom);
+
+        /* out of memory, it's turned off ('blocks' is 'NULL') */
+        if (!xbloom_init(&xh->bloom, cap, xh->bloom.bits))
+            return;
+    }
+    else
+    {
+        xbloom_clear(&xh->bloom);
+    }
+
+    for (iter = xhash_begin(xh); iter != xhash_end(xh);
+            iter = xhash_iter_next(xh, iter))
+        xbloom_add(&xh->bloom, iter->hash);
+
+    xh->bloom_stale = 0;
+}
+
+/* buckets are resized at once, refill the prefilter. */
+static inline void bloom_resized(xhash_t* xh)
+{
+    if (xh->bloom.blocks)
+        bloom_rebuild(xh);
+}
+
+static inline void bloom_add(xhash_t* xh, unsigned hash)
+{
+    if (xh->bloom.blocks)
+        xbloom_add(&xh->bloom, hash);
+#if XHASH_ENABLE_INCREMENTAL
+    if (xh->bloom_next.blocks)
+        xbloom_add(&xh->bloom_next, hash);
+#endif
+}
+
+/* 'hash' is definitely absent. */
+#define bloom_absent(xh, hash) \
+            ((xh)->bloom.blocks && !xbloom_may_contain(&(xh)->bloom, hash))
+
+/* 'n' elements are removed, they are still in the prefilter. */
+static inline void bloom_removed(xhash_t* xh, size_t n)
+{
+    if (!xh->bloom.blocks)
+        return;
+
+    xh->bloom_stale += n;
+
+#if XHASH_ENABLE_INCREMENTAL
+    /* the old filter is over its capacity until the migration is done */
+    if (xh->old_buckets)
+        return;
+#endif
+    if (xh->size + xh->bloom_stale > xh->bloom.capacity)
+        bloom_rebuild(xh);
+}
+
+/* all elements are removed. */
+static inline void bloom_cleared(xhash_t* xh)
+{
+    if (xh->bloom.blocks)
+    {
+        bloom_next_free(xh);
+        xbloom_clear(&xh->bloom);
+        xh->bloom_stale = 0;
+    }
+}
+
+#if XHASH_ENABLE_INCREMENTAL
+/* buckets are doubled, the old filter still has all elements (and is used by
+ * lookups), a new one for the new buckets is filled by migration. */
+static inline void bloom_expanded(xhash_t* xh)
+{
+    if (xh->bloom.blocks)
+    {
+        /* keep using the old one only if out of memory */
+        xbloom_init(&xh->bloom_next, xh->bkt_size * xh->loadfactor / 100,
+                    xh->bloom.bits);
+    }
+}
+
+/* the migration is done, every element is in the new filter. */
+static inline void bloom_migrated(xhash_t* xh)
+{
+    if (xh->bloom_next.blocks)
+    {
+        xbloom_destroy(&xh->bloom);
+        xh->bloom = xh->bloom_next;
+        xh->bloom_next.blocks = NULL;
+    }
+
+    if (xh->bloom.blocks && xh->size + xh->bloom_stale > xh->bloom.capacity)
+        bloom_rebuild(xh);
+}
+#endif
+#else
+#define bloom_resized(xh)           ((void)0)
+#define bloom_add(xh, hash)         ((void)0)
+#define bloom_absent(xh, hash)      0
+#define bloom_removed(xh, n)        ((void)0)
+#define bloom_cleared(xh)           ((void)0)
+#define bloom_expanded(xh)          ((void)0)
+#define bloom_migrated(xh)          ((void)0)
+#endif // XHASH_ENABLE_BLOOM
+
+#if XHASH_ENABLE_SLAB
+#if defined(_MSC_VER)
+#include <malloc.h>
+#define slab_alloc(sz)      _aligned_malloc(sz, sz)
+#define slab_free(s)        _aligned_free(s)
+#else
+#define slab_alloc(sz)      aligned_alloc(sz, sz)
+#define slab_free(s)        free(s)
+#endif
+
+#define SLAB_HEAD_SIZE      ((sizeof(xhash_slab_t) + 15) & ~(size_t)15)
+#define SLAB_MIN_NODES      8
+
+/* node size rounded up, so that every node in a slab is aligned. */
+#define node_size(xh) \
+            ((sizeof(xhash_node_t) + (xh)->data_size + 7) & ~(size_t)7)
+/* slabs are aligned to their size, find the slab by masking node address. */
+#define slab_of(xh, node) \
+            ((xhash_slab_t*)((size_t)(node) & ~((xh)->slab_size - 1)))
+#define slab_full(xh, s) \
+            (!(s)->free && (s)->carved == (xh)->slab_nodes)
+
+/* link 's' to the front of slab list. */
+static void slab_link(xhash_t* xh, xhash_slab_t* s)
+{
+    if (xh->slabs)
+    {
+        s->next = xh->slabs;
+        s->prev = xh->slabs->prev;
+        s->prev->next = s;
+        s->next->prev = s;
+    }
+    else
+    {
+        s->next = s;
+        s->prev = s;
+    }
+
+    xh->slabs = s;
+}
+
+static void slab_unlink(xhash_t* xh, xhash_slab_t* s)
+{
+    if (s->next == s)
+    {
+        xh->slabs = NULL;
+        return;
+    }
+
+    s->prev->next = s->next;
+    s->next->prev = s->prev;
+
+    if (xh->slabs == s)
+        xh->slabs = s->next;
+}
+
+static xhash_node_t* node_alloc(xhash_t* xh)
+{
+    xhash_slab_t* s = xh->slabs;
+    xhash_node_t* node;
+
+    /* slabs which have free nodes are in front, so if the
+     * first one is full, all slabs are full. */
+    if (!s || slab_full(xh, s))
+    {
+        s = slab_alloc(xh->slab_size);
+        if (!s)
+            return NULL;
+
+        s->free = NULL;
+        s->used = 0;
+        s->carved = 0;
+        slab_link(xh, s);
+        ++xh->slab_empty;
+    }
+
+    if (s->used++ == 0)
+        --xh->slab_empty;
+
+    if (s->free)
+    {
+        node = s->free;
+        s->free = node->next;
+        stats_add(xh, cache_hits, 1);
+    }
+    else
+    {
+        node = (xhash_node_t*)((char*)s + SLAB_HEAD_SIZE
+                    + s->carved++ * node_size(xh));
+    }
+
+    /* move the full slab to the back (circular list) */
+    if (slab_full(xh, s))
+        xh->slabs = s->next;
+
+    return node;
+}
+
+static void node_free(xhash_t* xh, xhash_node_t* node)
+{
+    xhash_slab_t* s;
+
+    if (bulk_has(xh, node))
+        return;
+
+    s = slab_of(xh, node);
+
+    if (--s->used == 0)
+    {
+        if (xh->slab_empty >= XHASH_SLAB_KEEP)
+        {
+            slab_unlink(xh, s);
+            slab_free(s);
+            return;
+        }
+        ++xh->slab_empty;
+    }
+
+    node->next = s->free;
+    s->free = node;
+
+    /* move to front, the next insertion reuses it */
+    if (xh->slabs != s)
+    {
+        slab_unlink(xh, s);
+        slab_link(xh, s);
+    }
+}
+
+/* release all empty slabs. */
+static void slabs_trim(xhash_t* xh)
+{
+    xhash_slab_t* s;
+
+    while (xh->slab_empty)
+    {
+        for (s = xh->slabs; s->used; s = s->next)
+            ;
+        slab_unlink(xh, s);
+        slab_free(s);
+        --xh->slab_empty;
+    }
+}
+
+/* release all slabs but 'keep' of them, which are reset to empty. */
+static void slabs_release(xhash_t* xh, size_t keep)
+{
+    xhash_slab_t* kept = NULL; // linked by 'next'
+    xhash_slab_t* s;
+
+    while ((s = xh->slabs))
+    {
+        slab_unlink(xh, s);
+
+        if (keep > 0)
+        {
+            --keep;
+            s->next = kept;
+            kept = s;
+        }
+        else
+        {
+            slab_free(s);
+        }
+    }
+
+    xh->slab_empty = 0;
+
+    while ((s = kept))
+    {
+        kept = s->next;
+        s->free = NULL;
+        s->used = 0;
+        s->carved = 0;
+        slab_link(xh, s);
+        ++xh->slab_empty;
+    }
+}
+#else
+static inline xhash_node_t* node_alloc(xhash_t* xh)
+{
+#if XHASH_ENABLE_CACHE
+    xhash_node_t* node = xh->cache;
+
+    if (node)
+    {
+        xh->cache = node->next;
+        stats_add(xh, cache_hits, 1);
+        return node;
+    }
+#endif
+    return malloc(sizeof(xhash_node_t) + xh->data_size);
+}
+
+static inline void node_free(xhash_t* xh, xhash_node_t* node)
+{
+    if (bulk_has(xh, node))
+        return;
+#if XHASH_ENABLE_CACHE
+    node->next = xh->cache;
+    xh->cache = node;
+#else
+    free(node);
+#endif
+}
+#endif
+
+#if XHASH_ENABLE_INCREMENTAL
+/* return the bucket which 'hash' lives in. when a migration is in flight,
+ * the old buckets which have not been migrated are still in use. */
+static inline xhash_node_t** bucket_of(xhash_t* xh, unsigned hash)
+{
+    if (xh->old_buckets
+        && (hash & (xh->old_bkt_size - 1)) >= xh->rehash_idx)
+        return &xh->old_buckets[hash & (xh->old_bkt_size - 1)];
+
+    return &xh->buckets[hash & (xh->bkt_size - 1)];
+}
+
+/* migrate at most 'n' old buckets into new buckets. every old bucket 'i' is
+ * split into new bucket 'i' and 'i + old_bkt_size' with nodes order kept,
+ * so that the traversal order is not changed by migration. */
+static void buckets_migrate(xhash_t* xh, size_t n)
+{
+    size_t i = xh->rehash_idx;
+    size_t end = i + n < xh->old_bkt_size ? i + n : xh->old_bkt_size;
+    xhash_node_t** lo;
+    xhash_node_t** hi;
+    xhash_node_t* lo_prev;
+    xhash_node_t* hi_prev;
+    xhash_iter_t iter;
+    xhash_iter_t next;
+#if XHASH_ENABLE_BLOOM
+    xbloom_t* bloom = xh->bloom_next.blocks ? &xh->bloom_next : NULL;
+#endif
+
+    for (; i < end; ++i)
+    {
+        iter = xh->old_buckets[i];
+
+        if (!iter) continue;
+
+        /* these two new buckets are empty before migration */
+        lo = &xh->buckets[i];
+        hi = &xh->buckets[i + xh->old_bkt_size];
+        lo_prev = NULL;
+        hi_prev = NULL;
+
+        do
+        {
+            next = iter->next;
+#if XHASH_ENABLE_BLOOM
+            if (bloom)
+                xbloom_add(bloom, iter->hash);
+#endif
+
+            if (iter->hash & xh->old_bkt_size)
+            {
+                iter->prev = hi_prev;
+                *hi = iter;
+                hi = &iter->next;
+                hi_prev = iter;
+            }
+            else
+            {
+                iter->prev = lo_prev;
+                *lo = iter;
+                lo = &iter->next;
+                lo_prev = iter;
+            }
+
+            iter = next;
+        }
+        while (iter);
+
+        *lo = NULL;
+        *hi = NULL;
+        xh->old_buckets[i] = NULL;
+    }
+
+    xh->rehash_idx = i;
+
+    if (i == xh->old_bkt_size)
+    {
+        free(xh->old_buckets);
+        xh->old_buckets = NULL;
+        bloom_migrated(xh);
+    }
+}
+
+/* allocate the new buckets only, nodes are migrated later. */
+static int buckets_expand(xhash_t* xh)
+{
+    size_t new_sz = xh->bkt_size << 1;
+    xhash_node_t** new_bkts;
+#if XHASH_ENABLE_STATS
+    unsigned long long begin = stats_now();
+#endif
+
+    /* the previous migration is not done (only when loadfactor
+     * is very large), finish it first. */
+    if (xh->old_buckets)
+        buckets_migrate(xh, xh->old_bkt_size);
+
+    /* 'calloc' can get zeroed pages from system without touching them */
+    new_bkts = calloc(new_sz, sizeof(xhash_node_t*));
+    if (!new_bkts) return -1;
+
+    xh->rehash_idx = 0;
+    xh->old_bkt_size = xh->bkt_size;
+    xh->old_buckets = xh->buckets;
+    xh->bkt_size = new_sz;
+    xh->buckets = new_bkts;
+
+    bloom_expanded(xh);
+#if XHASH_ENABLE_STATS
+    stats_resized(xh, begin);
+#endif
+    return 0;
+}
+#else
+#define bucket_of(xh, hash) (&(xh)->buckets[(hash) & ((xh)->bkt_size - 1)])
+
 static int buckets_expand(xhash_t* xh)
 {
     size_t i;
@@ -16,6 +554,10 @@ static int buckets_expand(xhash_t* xh)
                         sizeof(xhash_node_t*) * new_sz);
     xhash_iter_t unlinked;
     xhash_iter_t iter;
+    xhash_iter_t tail;
+#if XHASH_ENABLE_STATS
+    unsigned long long begin = stats_now();
+#endif
 
     if (!new_bkts) return -1;
 
@@ -26,6 +568,7 @@ static int buckets_expand(xhash_t* xh)
     for (i = 0; i < xh->bkt_size; ++i)
     {
         iter = new_bkts[i];
+        tail = NULL;
 
         while (iter)
         {
@@ -42,14 +585,17 @@ static int buckets_expand(xhash_t* xh)
                 else
                     new_bkts[i] = iter;
 
-                /* insert unlinked node into buckets[i + bkt_size] */
-                unlinked->prev = NULL;
-                unlinked->next = new_bkts[i + xh->bkt_size];
+                /* append unlinked node to buckets[i + bkt_size], so that
+                 * the order of equal elements is kept */
+                unlinked->prev = tail;
+                unlinked->next = NULL;
 
-                if (unlinked->next)
-                    unlinked->next->prev = unlinked;
+                if (tail)
+                    tail->next = unlinked;
+                else
+                    new_bkts[i + xh->bkt_size] = unlinked;
 
-                new_bkts[i + xh->bkt_size] = unlinked;
+                tail = unlinked;
             }
             else
             {
@@ -60,9 +606,135 @@ static int buckets_expand(xhash_t* xh)
 
     xh->bkt_size = new_sz;
     xh->buckets = new_bkts;
+
+    bloom_resized(xh);
+#if XHASH_ENABLE_STATS
+    stats_resized(xh, begin);
+#endif
+    return 0;
+}
+#endif // XHASH_ENABLE_INCREMENTAL
+
+/* rehash all nodes into 'new_sz' buckets at once, it can grow or shrink. */
+static int buckets_resize(xhash_t* xh, size_t new_sz)
+{
+    size_t i;
+    xhash_node_t** new_bkts;
+    xhash_node_t** bucket;
+    xhash_iter_t iter;
+    xhash_iter_t next;
+#if XHASH_ENABLE_STATS
+    unsigned long long begin = stats_now();
+#endif
+
+#if XHASH_ENABLE_INCREMENTAL
+    if (xh->old_buckets)
+        buckets_migrate(xh, xh->old_bkt_size);
+#endif
+    new_bkts = calloc(new_sz, sizeof(xhash_node_t*));
+    if (!new_bkts) return -1;
+
+    for (i = 0; i < xh->bkt_size; ++i)
+    {
+        /* equal elements are in the same old chain, push its nodes front
+         * from the last one, so that their order is kept */
+        if (!(iter = xh->buckets[i]))
+            continue;
+        while (iter->next)
+            iter = iter->next;
+
+        for (; iter; iter = next)
+        {
+            next = iter->prev;
+            bucket = &new_bkts[iter->hash & (new_sz - 1)];
+
+            /* push front */
+            iter->prev = NULL;
+            iter->next = *bucket;
+            if (*bucket)
+                (*bucket)->prev = iter;
+            *bucket = iter;
+        }
+    }
+
+    free(xh->buckets);
+
+    xh->bkt_size = new_sz;
+    xh->buckets = new_bkts;
+
+    bloom_resized(xh);
+#if XHASH_ENABLE_STATS
+    stats_resized(xh, begin);
+#endif
     return 0;
 }
 
+#if defined(__GNUC__)
+#define seed_counter_inc(p)     __atomic_add_fetch(p, 1, __ATOMIC_RELAXED)
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define seed_counter_inc(p)     _InterlockedIncrement64((volatile long long*)(p))
+#else
+#define seed_counter_inc(p)     (++*(p)) /* racy, seeds may repeat */
+#endif
+
+unsigned long long xhash_random_seed(void)
+{
+    static unsigned long long counter = 0;
+    unsigned long long s;
+
+    /* the addresses differ between processes when ASLR is on */
+    s = (unsigned long long)time(NULL) ^ (unsigned long long)clock() << 32;
+    s ^= (unsigned long long)(size_t)&s;
+    s ^= (unsigned long long)(size_t)&xhash_random_seed << 16;
+    s = xhash_mum(s ^ XHASH_P0, (unsigned long long)seed_counter_inc(&counter) ^ XHASH_P2);
+
+    /* 0 means no seed */
+    return s ? s : XHASH_P3;
+}
+
+/* return the minimum bucket size which can hold 'n' elements. */
+static size_t buckets_fit(xhash_t* xh, size_t n)
+{
+    size_t sz = XHASH_DEFAULT_SIZE;
+
+    while (n * 100 > sz * xh->loadfactor)
+        sz <<= 1;
+
+    return sz;
+}
+
+#if XHASH_ENABLE_DENSE
+static int dense_grow(xhash_t* xh)
+{
+    size_t cap = xh->dense_cap ? xh->dense_cap << 1 : XHASH_DEFAULT_SIZE;
+    xhash_node_t** dense = realloc(xh->dense, sizeof(xhash_node_t*) * cap);
+
+    if (!dense) return -1;
+
+    xh->dense_cap = cap;
+    xh->dense = dense;
+    return 0;
+}
+#endif
+
+/* return the last one of the adjacent elements equal to 'pdata' from 'iter'
+ * ('iter' is equal to 'pdata'), '*n' is increased by the number of them. */
+static xhash_iter_t run_last(xhash_t* xh,
+            xhash_iter_t iter, const void* pdata, size_t* n)
+{
+    ++*n;
+
+    while (iter->next && iter->next->hash == iter->hash
+        && xh->equal_cb(xhash_iter_data(iter->next), (void*)pdata))
+    {
+        iter = iter->next;
+        ++*n;
+    }
+
+    return iter;
+}
+
 static inline unsigned int align32pow2(unsigned int z)
 {
     z -= 1;
@@ -80,14 +752,52 @@ xhash_t* xhash_init(xhash_t* xh, int size, size_t data_size,
             xhash_destroy_cb destroy_cb)
 {
     xh->hash_cb     = hash_cb;
+    xh->seeded_hash_cb = NULL;
     xh->equal_cb    = equal_cb;
     xh->destroy_cb  = destroy_cb;
     xh->bkt_size    = size < XHASH_DEFAULT_SIZE ? XHASH_DEFAULT_SIZE : align32pow2(size);
     xh->data_size   = data_size;
     xh->size        = 0;
     xh->loadfactor  = XHASH_DEFAULT_LOADFACTOR;
+    xh->lowfactor   = 0;
+    xh->multi       = 0;
+    xh->bulk        = NULL;
+    xh->bulk_size   = 0;
+#if XHASH_ENABLE_BLOOM
+    xh->bloom_stale = 0;
+    memset(&xh->bloom, 0, sizeof(xbloom_t));
+#endif
+#if XHASH_ENABLE_STATS
+    memset(&xh->stats, 0, sizeof(xhash_stats_t));
+#endif
+#if XHASH_ENABLE_RANDOM_SEED
+    xh->seed        = xhash_random_seed();
+#else
+    xh->seed        = 0;
+#endif
 #if XHASH_ENABLE_CACHE
     xh->cache       = NULL;
+#endif
+#if XHASH_ENABLE_SLAB
+    xh->slabs       = NULL;
+    xh->slab_size   = XHASH_SLAB_SIZE;
+    xh->slab_empty  = 0;
+    /* big elements get bigger slabs */
+    while ((xh->slab_size - SLAB_HEAD_SIZE) / node_size(xh) < SLAB_MIN_NODES)
+        xh->slab_size <<= 1;
+    xh->slab_nodes  = (xh->slab_size - SLAB_HEAD_SIZE) / node_size(xh);
+#endif
+#if XHASH_ENABLE_DENSE
+    xh->dense_cap   = 0;
+    xh->dense       = NULL;
+#endif
+#if XHASH_ENABLE_INCREMENTAL
+    xh->rehash_idx  = 0;
+    xh->old_bkt_size= 0;
+    xh->old_buckets = NULL;
+#if XHASH_ENABLE_BLOOM
+    xh->bloom_next.blocks = NULL;
+#endif
 #endif
     xh->buckets     = malloc(sizeof(xhash_node_t*) * xh->bkt_size);
 
@@ -99,158 +809,800 @@ xhash_t* xhash_init(xhash_t* xh, int size, size_t data_size,
 
     return NULL;
 }
-
-void xhash_destroy(xhash_t* xh)
-{
-    xhash_clear(xh);
-#if XHASH_ENABLE_CACHE
-    xhash_cache_free(xh);
+
+void xhash_destroy(xhash_t* xh)
+{
+    xhash_clear(xh);
+#if XHASH_ENABLE_CACHE
+    xhash_cache_free(xh);
+#endif
+#if XHASH_ENABLE_SLAB
+    slabs_release(xh, 0);
+#endif
+#if XHASH_ENABLE_DENSE
+    free(xh->dense);
+#endif
+#if XHASH_ENABLE_INCREMENTAL
+    free(xh->old_buckets);
+#endif
+#if XHASH_ENABLE_BLOOM
+    bloom_next_free(xh);
+    xbloom_destroy(&xh->bloom);
+#endif
+    free(xh->buckets);
+}
+
+xhash_t* xhash_new(int size, size_t data_size, xhash_hash_cb hash_cb,
+            xhash_equal_cb equal_cb, xhash_destroy_cb destroy_cb)
+{
+    xhash_t* xh = malloc(sizeof(xhash_t));
+
+    if (xh)
+    {
+        if (xhash_init(xh, size, data_size,
+                hash_cb, equal_cb, destroy_cb))
+            return xh;
+        free(xh);
+    }
+
+    return NULL;
+}
+
+void xhash_free(xhash_t* xh)
+{
+    if (xh)
+    {
+        xhash_clear(xh);
+#if XHASH_ENABLE_CACHE
+        xhash_cache_free(xh);
+#endif
+#if XHASH_ENABLE_SLAB
+        slabs_release(xh, 0);
+#endif
+#if XHASH_ENABLE_DENSE
+        free(xh->dense);
+#endif
+#if XHASH_ENABLE_INCREMENTAL
+        free(xh->old_buckets);
+#endif
+#if XHASH_ENABLE_BLOOM
+        bloom_next_free(xh);
+        xbloom_destroy(&xh->bloom);
+#endif
+        free(xh->buckets);
+        free(xh);
+    }
+}
+
+xhash_iter_t xhash_put_hashed_ex(xhash_t* xh,
+            const void* pdata, size_t ksz, unsigned hash)
+{
+    xhash_node_t** bucket;
+    xhash_iter_t iter;
+    xhash_iter_t prev = NULL;
+    size_t n = 0;
+
+#if XHASH_ENABLE_INCREMENTAL
+    if (xh->old_buckets)
+        buckets_migrate(xh, XHASH_REHASH_STEP);
+#endif
+    bucket = bucket_of(xh, hash);
+    iter = *bucket;
+
+    while (iter)
+    {
+        if (hash == iter->hash
+            && xh->equal_cb(xhash_iter_data(iter), (void*)pdata))
+        {
+            if (!xh->multi)
+                return iter;
+
+            /* multimap, insert after the equal ones */
+            prev = run_last(xh, iter, pdata, &n);
+            break;
+        }
+
+        prev = iter;
+        iter = iter->next;
+    }
+
+#if XHASH_ENABLE_DENSE
+    if (xh->size == xh->dense_cap && dense_grow(xh) != 0)
+        return NULL;
+#endif
+    iter = node_alloc(xh);
+    if (!iter)
+        return NULL;
+
+    memcpy(xhash_iter_data(iter), pdata, ksz);
+
+    if (prev)
+    {
+        /* this bucket already has some node, link after 'prev' */
+        iter->next = prev->next;
+        if (iter->next)
+            iter->next->prev = iter;
+        prev->next = iter;
+        iter->prev = prev;
+    }
+    else
+    {
+        /* this bucket has no node, assign */
+        *bucket = iter;
+        iter->prev = NULL;
+        iter->next = NULL;
+    }
+
+    iter->hash = hash;
+    bloom_add(xh, hash);
+#if XHASH_ENABLE_DENSE
+    iter->index = (unsigned)xh->size;
+    xh->dense[xh->size] = iter;
+#endif
+
+    ++xh->size;
+    stats_add(xh, puts, 1);
+
+    /* check loadfactor */
+    if (xh->size * 100 > xh->bkt_size * xh->loadfactor)
+        buckets_expand(xh);
+
+    return iter;
+}
+
+xhash_iter_t xhash_get_hashed(xhash_t* xh,
+            const void* pdata, unsigned hash)
+{
+    xhash_iter_t iter;
+    size_t probes = 0;
+
+#if XHASH_ENABLE_INCREMENTAL
+    if (xh->old_buckets)
+        buckets_migrate(xh, XHASH_REHASH_STEP);
+#endif
+    /* definitely absent, don't touch the buckets */
+    if (bloom_absent(xh, hash))
+    {
+        stats_lookup(xh, probes, 0);
+        return NULL;
+    }
+
+    iter = *bucket_of(xh, hash);
+
+    while (iter)
+    {
+        ++probes;
+
+        if (hash == iter->hash
+            && xh->equal_cb(xhash_iter_data(iter), (void*)pdata))
+        {
+            stats_lookup(xh, probes, 1);
+            return iter;
+        }
+
+        iter = iter->next;
+    }
+
+    stats_lookup(xh, probes, 0);
+    return NULL;
+}
+
+xhash_iter_t xhash_put_ex(xhash_t* xh, const void* pdata, size_t ksz)
+{
+    return xhash_put_hashed_ex(xh, pdata, ksz, xhash_hash_of(xh, pdata));
+}
+
+xhash_iter_t xhash_get(xhash_t* xh, const void* pdata)
+{
+    return xhash_get_hashed(xh, pdata, xhash_hash_of(xh, pdata));
+}
+
+void xhash_get_many(xhash_t* xh, const void* const* pdatas,
+            size_t n, xhash_iter_t* iters)
+{
+    unsigned hashes[XHASH_BATCH_SIZE];
+    xhash_node_t** bkts[XHASH_BATCH_SIZE];
+    xhash_iter_t iter;
+    size_t i, m, probes;
+
+    for (; n > 0; n -= m, pdatas += m, iters += m)
+    {
+        m = n < XHASH_BATCH_SIZE ? n : XHASH_BATCH_SIZE;
+
+#if XHASH_ENABLE_INCREMENTAL
+        if (xh->old_buckets)
+            buckets_migrate(xh, XHASH_REHASH_STEP);
+#endif
+        /* stage 1: hash all keys and prefetch bucket heads */
+        for (i = 0; i < m; ++i)
+        {
+            hashes[i] = xhash_hash_of(xh, pdatas[i]);
+
+            if (bloom_absent(xh, hashes[i]))
+            {
+                bkts[i] = NULL;
+                continue;
+            }
+
+            bkts[i] = bucket_of(xh, hashes[i]);
+            xhash_prefetch(bkts[i]);
+        }
+
+        /* stage 2: load bucket heads and prefetch first nodes */
+        for (i = 0; i < m; ++i)
+        {
+            iters[i] = bkts[i] ? *bkts[i] : NULL;
+            if (iters[i])
+                xhash_prefetch(iters[i]);
+        }
+
+        /* stage 3: walk the chains */
+        for (i = 0; i < m; ++i)
+        {
+            iter = iters[i];
+            probes = 0;
+
+            while (iter)
+            {
+                ++probes;
+
+                if (hashes[i] == iter->hash
+                    && xh->equal_cb(xhash_iter_data(iter), (void*)pdatas[i]))
+                    break;
+                iter = iter->next;
+            }
+
+            stats_lookup(xh, probes, iter != NULL);
+            iters[i] = iter;
+        }
+    }
+}
+
+void xhash_put_many(xhash_t* xh, const void* const* pdatas,
+            size_t n, xhash_iter_t* iters)
+{
+    unsigned hashes[XHASH_BATCH_SIZE];
+    xhash_iter_t iter;
+    size_t i, m;
+
+    for (; n > 0; n -= m, pdatas += m)
+    {
+        m = n < XHASH_BATCH_SIZE ? n : XHASH_BATCH_SIZE;
+
+        for (i = 0; i < m; ++i)
+        {
+            hashes[i] = xhash_hash_of(xh, pdatas[i]);
+            xhash_prefetch(bucket_of(xh, hashes[i]));
+        }
+
+        /* buckets may expand during insertion, so the prefetched
+         * buckets are just hints, 'xhash_put_hashed_ex' locates them again. */
+        for (i = 0; i < m; ++i)
+        {
+            iter = xhash_put_hashed_ex(xh, pdatas[i], xh->data_size, hashes[i]);
+            if (iters)
+                *iters++ = iter;
+        }
+    }
+}
+
+typedef struct build_ctx    build_ctx_t;
+typedef struct build_task   build_task_t;
+
+/* shared state of 'xhash_build', threads work on disjoint parts of it. */
+struct build_ctx
+{
+    xhash_t*        xh;
+    const char*     records;
+    char*           nodes;      // node 'i' is made of record 'i'
+    size_t          node_size;
+    size_t          n;
+    unsigned*       order;      // node indexes grouped by partition
+    size_t*         counts;     // [nthreads][nparts], then write offsets
+    size_t*         starts;     // [nparts + 1], partitions in 'order'
+    size_t*         linked;     // [nparts], nodes linked in every partition
+    unsigned        part_shift; // bucket 'b' is in partition 'b >> part_shift'
+    int             nparts;
+    int             nthreads;
+};
+
+struct build_task
+{
+    build_ctx_t*    ctx;
+    int             id;
+    void            (*fn)(build_ctx_t* ctx, int id);
+};
+
+#define build_node(ctx, i) \
+            ((xhash_node_t*)((ctx)->nodes + (ctx)->node_size * (i)))
+#define build_part(ctx, hash) \
+            (((hash) & ((ctx)->xh->bkt_size - 1)) >> (ctx)->part_shift)
+#define build_first(ctx, id)    ((ctx)->n * (id) / (ctx)->nthreads)
+
+/* copy and hash the records of thread 'id', count them by partition. */
+static void build_hash(build_ctx_t* ctx, int id)
+{
+    size_t* counts = ctx->counts + (size_t)ctx->nparts * id;
+    size_t i, end = build_first(ctx, id + 1);
+    xhash_node_t* node;
+
+    for (i = build_first(ctx, id); i < end; ++i)
+    {
+        node = build_node(ctx, i);
+        memcpy(xhash_iter_data(node),
+            ctx->records + ctx->xh->data_size * i, ctx->xh->data_size);
+        node->hash = xhash_hash_of(ctx->xh, xhash_iter_data(node));
+        ++counts[build_part(ctx, node->hash)];
+    }
+}
+
+/* place the nodes of thread 'id' into their partitions, keep the order. */
+static void build_scatter(build_ctx_t* ctx, int id)
+{
+    size_t* offsets = ctx->counts + (size_t)ctx->nparts * id;
+    size_t i, end = build_first(ctx, id + 1);
+
+    for (i = build_first(ctx, id); i < end; ++i)
+        ctx->order[offsets[build_part(ctx, build_node(ctx, i)->hash)]++] = (unsigned)i;
+}
+
+/* link the nodes of the partitions of thread 'id', no other thread touches
+ * their buckets. the linked ones are moved to the front of the partition. */
+static void build_link(build_ctx_t* ctx, int id)
+{
+    xhash_t* xh = ctx->xh;
+    xhash_node_t** bucket;
+    xhash_iter_t node;
+    xhash_iter_t iter;
+    xhash_iter_t prev;
+    size_t k, end, linked, dup = 0;
+    int p;
+
+    for (p = id; p < ctx->nparts; p += ctx->nthreads)
+    {
+        end = ctx->starts[p + 1];
+        linked = 0;
+
+        for (k = ctx->starts[p]; k < end; ++k)
+        {
+            /* nodes are visited in address order, buckets are random */
+            if (k + XHASH_BATCH_SIZE < end)
+                xhash_prefetch(&xh->buckets[build_node(ctx,
+                    ctx->order[k + XHASH_BATCH_SIZE])->hash & (xh->bkt_size - 1)]);
+
+            node = build_node(ctx, ctx->order[k]);
+            bucket = &xh->buckets[node->hash & (xh->bkt_size - 1)];
+            iter = *bucket;
+            prev = NULL;
+
+            while (iter)
+            {
+                if (node->hash == iter->hash && xh->equal_cb(
+                        xhash_iter_data(iter), xhash_iter_data(node)))
+                {
+                    if (xh->multi)
+                    {
+                        /* multimap, insert after the equal ones */
+                        prev = run_last(xh, iter, xhash_iter_data(node), &dup);
+                        iter = NULL;
+                    }
+                    break;
+                }
+
+                prev = iter;
+                iter = iter->next;
+            }
+
+            /* duplicate, dropped */
+            if (iter) continue;
+
+            if (prev)
+            {
+                node->next = prev->next;
+                if (node->next)
+                    node->next->prev = node;
+                prev->next = node;
+                node->prev = prev;
+            }
+            else
+            {
+                *bucket = node;
+                node->prev = NULL;
+                node->next = NULL;
+            }
+
+            ctx->order[ctx->starts[p] + linked++] = ctx->order[k];
+        }
+
+        ctx->linked[p] = linked;
+    }
+}
+
+#if XHASH_ENABLE_DENSE
+/* fill 'dense' with the linked nodes of the partitions of thread 'id',
+ * 'linked[p]' is the offset of partition 'p' in 'dense' now. */
+static void build_dense(build_ctx_t* ctx, int id)
+{
+    xhash_node_t** dense = ctx->xh->dense;
+    size_t k, j;
+    int p;
+
+    for (p = id; p < ctx->nparts; p += ctx->nthreads)
+    {
+        j = ctx->linked[p];
+
+        for (k = ctx->starts[p]; j < ctx->linked[p + 1]; ++k, ++j)
+        {
+            dense[j] = build_node(ctx, ctx->order[k]);
+            dense[j]->index = (unsigned)j;
+        }
+    }
+}
+#endif
+
+#if XHASH_ENABLE_THREADS
+static void* build_thread(void* arg)
+{
+    build_task_t* task = arg;
+
+    task->fn(task->ctx, task->id);
+    return NULL;
+}
 #endif
-    free(xh->buckets);
-}
 
-xhash_t* xhash_new(int size, size_t data_size, xhash_hash_cb hash_cb,
-            xhash_equal_cb equal_cb, xhash_destroy_cb destroy_cb)
+/* run 'fn' by all threads of 'ctx', the caller is thread 0. */
+static void build_run(build_ctx_t* ctx, void (*fn)(build_ctx_t*, int))
 {
-    xhash_t* xh = malloc(sizeof(xhash_t));
+#if XHASH_ENABLE_THREADS
+    build_task_t tasks[XHASH_BUILD_MAX_THREADS];
+    pthread_t threads[XHASH_BUILD_MAX_THREADS];
+    int started[XHASH_BUILD_MAX_THREADS];
+    int i;
 
-    if (xh)
+    for (i = 1; i < ctx->nthreads; ++i)
     {
-        if (xhash_init(xh, size, data_size,
-                hash_cb, equal_cb, destroy_cb))
-            return xh;
-        free(xh);
+        tasks[i].ctx = ctx;
+        tasks[i].id = i;
+        tasks[i].fn = fn;
+        started[i] = pthread_create(&threads[i], NULL, build_thread, &tasks[i]) == 0;
+
+        /* do it here if the thread can't be created */
+        if (!started[i])
+            fn(ctx, i);
     }
 
-    return NULL;
-}
+    fn(ctx, 0);
 
-void xhash_free(xhash_t* xh)
-{
-    if (xh)
+    for (i = 1; i < ctx->nthreads; ++i)
     {
-        xhash_clear(xh);
-#if XHASH_ENABLE_CACHE
-        xhash_cache_free(xh);
-#endif
-        free(xh->buckets);
-        free(xh);
+        if (started[i])
+            pthread_join(threads[i], NULL);
     }
+#else
+    int i;
+
+    for (i = 0; i < ctx->nthreads; ++i)
+        fn(ctx, i);
+#endif
 }
 
-xhash_iter_t xhash_put_ex(xhash_t* xh, const void* pdata, size_t ksz)
+int xhash_build(xhash_t* xh, const void* records, size_t n, int nthreads)
 {
-    unsigned hash = xh->hash_cb((void*)pdata);
-    xhash_iter_t iter = xh->buckets[hash & (xh->bkt_size - 1)];
-    xhash_iter_t prev = NULL;
+    build_ctx_t ctx;
+    xhash_node_t** buckets;
+    size_t bkt_size = buckets_fit(xh, n);
+    size_t sum, c;
+    int ret = -1;
+    int p, t;
 
-    while (iter)
+    if (!xhash_empty(xh) || n >= 0xffffffffU)
+        return -1;
+    if (n == 0)
+        return 0;
+
+    if (nthreads < 1)
+        nthreads = 1;
+    if (nthreads > XHASH_BUILD_MAX_THREADS)
+        nthreads = XHASH_BUILD_MAX_THREADS;
+#if !XHASH_ENABLE_THREADS
+    nthreads = 1;
+#endif
+
+    /* a few partitions per thread, so that they are balanced */
+    ctx.nparts = 1;
+    ctx.part_shift = 0;
+    while (ctx.nparts < nthreads * 4 && ((size_t)ctx.nparts << 1) <= bkt_size)
+        ctx.nparts <<= 1;
+    for (c = bkt_size / ctx.nparts; c > 1; c >>= 1)
+        ++ctx.part_shift;
+
+    ctx.xh          = xh;
+    ctx.records     = records;
+    ctx.n           = n;
+    ctx.nthreads    = nthreads;
+    /* the same size as the nodes of the slab allocator, keep them aligned */
+    ctx.node_size   = (sizeof(xhash_node_t) + xh->data_size + 7) & ~(size_t)7;
+    ctx.nodes       = malloc(ctx.node_size * n);
+    ctx.order       = malloc(sizeof(unsigned) * n);
+    ctx.counts      = calloc((size_t)nthreads * ctx.nparts, sizeof(size_t));
+    ctx.starts      = malloc(sizeof(size_t) * (ctx.nparts + 1));
+    ctx.linked      = malloc(sizeof(size_t) * (ctx.nparts + 1));
+    buckets         = calloc(bkt_size, sizeof(xhash_node_t*));
+
+    if (!ctx.nodes || !ctx.order || !ctx.counts || !ctx.starts
+        || !ctx.linked || !buckets)
+        goto out;
+
+#if XHASH_ENABLE_DENSE
+    if (n > xh->dense_cap)
     {
-        if (hash == iter->hash
-            && xh->equal_cb(xhash_iter_data(iter), (void*)pdata))
-        {
-            return iter;
-        }
+        xhash_node_t** dense = realloc(xh->dense, sizeof(xhash_node_t*) * n);
 
-        prev = iter;
-        iter = iter->next;
+        if (!dense) goto out;
+
+        xh->dense_cap = n;
+        xh->dense = dense;
     }
+#endif
 
-#if XHASH_ENABLE_CACHE
-    if (xh->cache)
+    /* the nodes removed before are in 'bulk', it's empty now */
+    bulk_free(xh);
+#if XHASH_ENABLE_INCREMENTAL
+    free(xh->old_buckets);
+    xh->old_buckets = NULL;
+#endif
+    free(xh->buckets);
+    xh->buckets = buckets;
+    xh->bkt_size = bkt_size;
+    xh->bulk = ctx.nodes;
+    xh->bulk_size = ctx.node_size * n;
+
+    build_run(&ctx, build_hash);
+
+    /* partition 'p' of thread 't' starts after the partitions before 'p'
+     * and partition 'p' of the threads before 't'. */
+    for (sum = 0, p = 0; p < ctx.nparts; ++p)
     {
-        iter = xh->cache;
-        xh->cache = iter->next;
+        ctx.starts[p] = sum;
+
+        for (t = 0; t < nthreads; ++t)
+        {
+            c = ctx.counts[(size_t)ctx.nparts * t + p];
+            ctx.counts[(size_t)ctx.nparts * t + p] = sum;
+            sum += c;
+        }
     }
-    else
+    ctx.starts[ctx.nparts] = sum;
+
+    build_run(&ctx, build_scatter);
+    build_run(&ctx, build_link);
+
+    for (sum = 0, p = 0; p < ctx.nparts; ++p)
     {
-#endif
-        iter = malloc(sizeof(xhash_node_t) + xh->data_size);
-        if (!iter)
-            return NULL;
-#if XHASH_ENABLE_CACHE
+        c = ctx.linked[p];
+        ctx.linked[p] = sum;
+        sum += c;
     }
+    ctx.linked[ctx.nparts] = sum;
+
+#if XHASH_ENABLE_DENSE
+    build_run(&ctx, build_dense);
 #endif
-    memcpy(xhash_iter_data(iter), pdata, ksz);
+    xh->size = sum;
+    stats_add(xh, puts, sum);
+    bloom_resized(xh);
+    ret = 0;
 
-    if (prev)
+out:
+    if (ret != 0)
     {
-        /* this bucket already has some node, append */
-        prev->next = iter;
-        iter->prev = prev;
+        free(ctx.nodes);
+        free(buckets);
     }
+    free(ctx.order);
+    free(ctx.counts);
+    free(ctx.starts);
+    free(ctx.linked);
+    return ret;
+}
+
+void xhash_remove(xhash_t* xh, xhash_iter_t iter)
+{
+#if XHASH_ENABLE_INCREMENTAL
+    if (xh->old_buckets)
+        buckets_migrate(xh, XHASH_REHASH_STEP);
+#endif
+    if (iter->prev)
+        iter->prev->next = iter->next;
+    else
+        *bucket_of(xh, iter->hash) = iter->next;
+
+    if (iter->next)
+        iter->next->prev = iter->prev;
+
+    if (xh->destroy_cb)
+        xh->destroy_cb(xhash_iter_data(iter));
+
+#if XHASH_ENABLE_DENSE
+    /* move the last one into the hole */
+    xh->dense[iter->index] = xh->dense[xh->size - 1];
+    xh->dense[iter->index]->index = iter->index;
+#endif
+    node_free(xh, iter);
+
+    --xh->size;
+    bloom_removed(xh, 1);
+
+    /* check low-water loadfactor */
+    if (xh->size * 100 < xh->bkt_size * xh->lowfactor
+        && xh->bkt_size > XHASH_DEFAULT_SIZE)
+        buckets_resize(xh, xh->bkt_size >> 1);
+}
+
+xhash_iter_t xhash_equal_range(xhash_t* xh, const void* pdata, xhash_iter_t* end)
+{
+    xhash_iter_t first = xhash_get(xh, pdata);
+    size_t n = 0;
+
+    *end = first ? run_last(xh, first, pdata, &n)->next : NULL;
+    return first;
+}
+
+size_t xhash_count(xhash_t* xh, const void* pdata)
+{
+    xhash_iter_t first = xhash_get(xh, pdata);
+    size_t n = 0;
+
+    if (first)
+        run_last(xh, first, pdata, &n);
+    return n;
+}
+
+size_t xhash_remove_all(xhash_t* xh, const void* pdata)
+{
+    xhash_iter_t first = xhash_get(xh, pdata);
+    xhash_iter_t last;
+    xhash_iter_t next;
+    size_t sz, n = 0;
+
+    if (!first)
+        return 0;
+
+    last = run_last(xh, first, pdata, &n);
+
+    /* unlink the whole range */
+    if (first->prev)
+        first->prev->next = last->next;
     else
+        *bucket_of(xh, first->hash) = last->next;
+
+    if (last->next)
+        last->next->prev = first->prev;
+
+    last->next = NULL;
+
+    for (; first; first = next)
     {
-        /* this bucket has no node, assign */
-        xh->buckets[hash & (xh->bkt_size - 1)] = iter;
-        iter->prev = NULL;
+        next = first->next;
+
+        if (xh->destroy_cb)
+            xh->destroy_cb(xhash_iter_data(first));
+
+#if XHASH_ENABLE_DENSE
+        xh->dense[first->index] = xh->dense[xh->size - 1];
+        xh->dense[first->index]->index = first->index;
+#endif
+        node_free(xh, first);
+
+        --xh->size;
     }
 
-    iter->next = NULL;
-    iter->hash = hash;
+    bloom_removed(xh, n);
 
-    ++xh->size;
+    /* check low-water loadfactor */
+    for (sz = xh->bkt_size; xh->size * 100 < sz * xh->lowfactor
+            && sz > XHASH_DEFAULT_SIZE; sz >>= 1)
+        ;
+    if (sz != xh->bkt_size)
+        buckets_resize(xh, sz);
 
-    /* check loadfactor */
-    if (xh->size * 100 > xh->bkt_size * xh->loadfactor)
-        buckets_expand(xh);
+    return n;
+}
 
-    return iter;
+#if XHASH_ENABLE_BLOOM
+int xhash_set_bloom(xhash_t* xh, unsigned bits)
+{
+    bloom_next_free(xh);
+    xbloom_destroy(&xh->bloom);
+    memset(&xh->bloom, 0, sizeof(xbloom_t));
+    xh->bloom_stale = 0;
+
+    if (bits == 0)
+        return 0;
+
+    xh->bloom.bits = bits;
+    bloom_rebuild(xh);
+
+    return xh->bloom.blocks ? 0 : -1;
 }
+#endif
 
-xhash_iter_t xhash_get(xhash_t* xh, const void* pdata)
+int xhash_reserve(xhash_t* xh, size_t n)
 {
-    unsigned hash = xh->hash_cb((void*)pdata);
-    xhash_iter_t iter = xh->buckets[hash & (xh->bkt_size - 1)];
+    size_t sz = buckets_fit(xh, n);
 
-    while (iter)
+#if XHASH_ENABLE_DENSE
+    if (n > xh->dense_cap)
     {
-        if (hash == iter->hash
-            && xh->equal_cb(xhash_iter_data(iter), (void*)pdata))
-        {
-            return iter;
-        }
+        xhash_node_t** dense = realloc(xh->dense, sizeof(xhash_node_t*) * n);
 
-        iter = iter->next;
+        if (!dense) return -1;
+
+        xh->dense_cap = n;
+        xh->dense = dense;
     }
+#endif
+    if (sz > xh->bkt_size)
+        return buckets_resize(xh, sz);
 
-    return NULL;
+    return 0;
 }
 
-void xhash_remove(xhash_t* xh, xhash_iter_t iter)
+void xhash_shrink_to_fit(xhash_t* xh)
 {
-    if (iter->prev)
-        iter->prev->next = iter->next;
-    else
-        xh->buckets[iter->hash & (xh->bkt_size - 1)] = iter->next;
+    size_t sz = buckets_fit(xh, xh->size);
 
-    if (iter->next)
-        iter->next->prev = iter->prev;
+    /* keep the old buckets when out of memory */
+    if (sz < xh->bkt_size)
+        buckets_resize(xh, sz);
 
-    if (xh->destroy_cb)
-        xh->destroy_cb(xhash_iter_data(iter));
+#if XHASH_ENABLE_DENSE
+    if (xh->size == 0)
+    {
+        free(xh->dense);
+        xh->dense_cap = 0;
+        xh->dense = NULL;
+    }
+    else if (xh->size < xh->dense_cap)
+    {
+        xhash_node_t** dense = realloc(xh->dense, sizeof(xhash_node_t*) * xh->size);
 
+        if (dense)
+        {
+            xh->dense_cap = xh->size;
+            xh->dense = dense;
+        }
+    }
+#endif
 #if XHASH_ENABLE_CACHE
-    iter->next = xh->cache;
-    xh->cache = iter;
-#else
-    free(iter);
+    xhash_cache_free(xh);
 #endif
-
-    --xh->size;
+#if XHASH_ENABLE_SLAB
+    slabs_trim(xh);
+#endif
+    if (xh->size == 0)
+        bulk_free(xh);
 }
 
-void xhash_clear(xhash_t* xh)
+#if !XHASH_ENABLE_DENSE
+static void buckets_clear(xhash_t* xh,
+            xhash_node_t** buckets, size_t bkt_size)
 {
     size_t i;
     xhash_node_t* curr = NULL;
     xhash_node_t* next;
 
-    if (xhash_empty(xh)) return;
-
-    for (i = 0; i < xh->bkt_size; ++i)
+#if XHASH_ENABLE_SLAB
+    /* nodes are released with their slabs, visit them only for 'destroy_cb' */
+    if (!xh->destroy_cb)
+    {
+        memset(buckets, 0, sizeof(xhash_node_t*) * bkt_size);
+        return;
+    }
+#endif
+    for (i = 0; i < bkt_size; ++i)
     {
-        curr = xh->buckets[i];
+        curr = buckets[i];
 
         if (!curr) continue;
 
@@ -260,14 +1612,73 @@ void xhash_clear(xhash_t* xh)
 
             if (xh->destroy_cb)
                 xh->destroy_cb(xhash_iter_data(curr));
-            free(curr);
+#if !XHASH_ENABLE_SLAB
+            if (!bulk_has(xh, curr))
+                free(curr);
+#endif
 
             curr = next;
         }
         while (curr);
 
-        xh->buckets[i] = NULL;
+        buckets[i] = NULL;
+    }
+}
+#else
+/* all nodes are in 'dense', walk it instead of buckets. */
+static void dense_clear(xhash_t* xh)
+{
+    size_t i;
+
+#if XHASH_ENABLE_SLAB
+    if (xh->destroy_cb)
+#endif
+    for (i = 0; i < xh->size; ++i)
+    {
+        if (xh->destroy_cb)
+            xh->destroy_cb(xhash_iter_data(xh->dense[i]));
+#if !XHASH_ENABLE_SLAB
+        if (!bulk_has(xh, xh->dense[i]))
+            free(xh->dense[i]);
+#endif
+    }
+
+#if XHASH_ENABLE_INCREMENTAL
+    free(xh->old_buckets);
+    xh->old_buckets = NULL;
+#endif
+    memset(xh->buckets, 0, sizeof(xhash_node_t*) * xh->bkt_size);
+}
+#endif
+
+void xhash_clear(xhash_t* xh)
+{
+    if (xhash_empty(xh))
+    {
+        /* the built nodes may have been removed one by one */
+        bulk_free(xh);
+        return;
+    }
+
+#if XHASH_ENABLE_DENSE
+    dense_clear(xh);
+#else
+#if XHASH_ENABLE_INCREMENTAL
+    if (xh->old_buckets)
+    {
+        /* drop the migration, buckets before 'rehash_idx' are empty */
+        buckets_clear(xh, xh->old_buckets, xh->old_bkt_size);
+        free(xh->old_buckets);
+        xh->old_buckets = NULL;
     }
+#endif
+    buckets_clear(xh, xh->buckets, xh->bkt_size);
+#endif
+#if XHASH_ENABLE_SLAB
+    slabs_release(xh, XHASH_SLAB_KEEP);
+#endif
+    bulk_free(xh);
+    bloom_cleared(xh);
 
     xh->size = 0;
 }
@@ -286,14 +1697,126 @@ void xhash_cache_free(xhash_t* xh)
 }
 #endif
 
+/* count the nodes of 'n' buckets into the histogram of 'out'. */
+static void stats_chains(xhash_stats_t* out, xhash_node_t** buckets, size_t n)
+{
+    xhash_iter_t iter;
+    size_t i, len;
+
+    for (i = 0; i < n; ++i)
+    {
+        for (len = 0, iter = buckets[i]; iter; iter = iter->next)
+            ++len;
+
+        if (len > out->max_chain)
+            out->max_chain = len;
+
+        ++out->chains[len < XHASH_STATS_CHAINS ? len : XHASH_STATS_CHAINS - 1];
+    }
+}
+
+void xhash_stats(xhash_t* xh, xhash_stats_t* out)
+{
+#if XHASH_ENABLE_STATS
+    *out = xh->stats;
+#else
+    memset(out, 0, sizeof(xhash_stats_t));
+#endif
+    out->size = xh->size;
+    out->bkt_size = xh->bkt_size;
+    out->max_chain = 0;
+    memset(out->chains, 0, sizeof(out->chains));
+
+#if XHASH_ENABLE_INCREMENTAL
+    /* new buckets which have not been migrated into are not counted */
+    if (xh->old_buckets)
+    {
+        stats_chains(out, xh->buckets, xh->rehash_idx);
+        stats_chains(out, xh->buckets + xh->old_bkt_size, xh->rehash_idx);
+        stats_chains(out, xh->old_buckets + xh->rehash_idx,
+            xh->old_bkt_size - xh->rehash_idx);
+        return;
+    }
+#endif
+    stats_chains(out, xh->buckets, xh->bkt_size);
+}
+
+#if XHASH_ENABLE_INCREMENTAL && !XHASH_ENABLE_DENSE
+/* return the first node which belongs to new bucket 'i', it may
+ * still live in an old bucket which has not been migrated. */
+static xhash_iter_t bucket_first(xhash_t* xh, size_t i)
+{
+    xhash_iter_t iter;
+
+    if (xh->old_buckets
+        && (i & (xh->old_bkt_size - 1)) >= xh->rehash_idx)
+    {
+        iter = xh->old_buckets[i & (xh->old_bkt_size - 1)];
+
+        while (iter && (iter->hash & (xh->bkt_size - 1)) != i)
+            iter = iter->next;
+        return iter;
+    }
+
+    return xh->buckets[i];
+}
+
+/* return the next node which belongs to the same new bucket of 'iter'. */
+static xhash_iter_t bucket_next(xhash_t* xh, xhash_iter_t iter)
+{
+    size_t i = iter->hash & (xh->bkt_size - 1);
+
+    if (xh->old_buckets
+        && (iter->hash & (xh->old_bkt_size - 1)) >= xh->rehash_idx)
+    {
+        do
+            iter = iter->next;
+        while (iter && (iter->hash & (xh->bkt_size - 1)) != i);
+        return iter;
+    }
+
+    return iter->next;
+}
+#else
+#define bucket_first(xh, i)     ((xh)->buckets[i])
+#define bucket_next(xh, iter)   ((iter)->next)
+#endif // XHASH_ENABLE_INCREMENTAL && !XHASH_ENABLE_DENSE
+
+#if XHASH_ENABLE_DENSE
+xhash_iter_t xhash_begin(xhash_t* xh)
+{
+    /* from the last one, so that the current one can be removed */
+    return xh->size ? xh->dense[xh->size - 1] : NULL;
+}
+
+xhash_iter_t xhash_iter_next(xhash_t* xh, xhash_iter_t iter)
+{
+    return iter->index ? xh->dense[iter->index - 1] : NULL;
+}
+
+void xhash_foreach(xhash_t* xh, xhash_foreach_cb cb, void* ctx)
+{
+    size_t i;
+
+    for (i = 0; i < xh->size; ++i)
+    {
+        /* nodes are not contiguous, fetch them ahead */
+        if (i + XHASH_BATCH_SIZE < xh->size)
+            xhash_prefetch(xh->dense[i + XHASH_BATCH_SIZE]);
+
+        cb(xhash_iter_data(xh->dense[i]), ctx);
+    }
+}
+#else
 xhash_iter_t xhash_begin(xhash_t* xh)
 {
     size_t i;
+    xhash_iter_t iter;
 
     for (i = 0; i < xh->bkt_size; ++i)
     {
-        if (xh->buckets[i])
-            return xh->buckets[i];
+        if ((iter = bucket_first(xh, i)))
+            return iter;
     }
 
     return NULL;
@@ -302,17 +1825,43 @@ xhash_iter_t xhash_begin(xhash_t* xh)
 xhash_iter_t xhash_iter_next(xhash_t* xh, xhash_iter_t iter)
 {
     size_t i;
+    xhash_iter_t next = bucket_next(xh, iter);
 
-    if (iter->next)
-        return iter->next;
+    if (next)
+        return next;
 
     i = iter->hash & (xh->bkt_size - 1);
 
     while (++i < xh->bkt_size)
     {
-        if (xh->buckets[i])
-            return xh->buckets[i];
+        if ((next = bucket_first(xh, i)))
+            return next;
     }
 
     return NULL;
-}
\ No newline at end of file
+}
+
+void xhash_foreach(xhash_t* xh, xhash_foreach_cb cb, void* ctx)
+{
+    size_t i, n = 0;
+    xhash_iter_t iter;
+
+    /* stop when all elements are visited */
+    for (i = 0; i < xh->bkt_size && n < xh->size; ++i)
+    {
+        for (iter = xh->buckets[i]; iter; iter = iter->next, ++n)
+            cb(xhash_iter_data(iter), ctx);
+    }
+#if XHASH_ENABLE_INCREMENTAL
+    /* the old buckets which have not been migrated */
+    if (xh->old_buckets)
+    {
+        for (i = xh->rehash_idx; i < xh->old_bkt_size && n < xh->size; ++i)
+        {
+            for (iter = xh->old_buckets[i]; iter; iter = iter->next, ++n)
+                cb(xhash_iter_data(iter), ctx);
+        }
+    }
+#endif
+}
+#endif // XHASH_ENABLE_DENSE
\ No newline at end of file
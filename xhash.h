@@ -7,6 +7,10 @@
 #define _XHASH_H_
 
 #include <stddef.h>
+#include <string.h>
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
 
 /* Hash table, logic based on java hash table. */
 
@@ -29,35 +33,191 @@
 #define XHASH_DEFAULT_LOADFACTOR    75 // percent
 #endif
 
+/* incremental rehash can avoid the latency spike when buckets expand.
+ * the old buckets are kept alive after expanding, and every put/get/remove
+ * migrates 'XHASH_REHASH_STEP' of them into the new buckets.
+ * define 'XHASH_ENABLE_INCREMENTAL=1' to enable it. */
+#ifndef XHASH_ENABLE_INCREMENTAL
+#define XHASH_ENABLE_INCREMENTAL    0
+#endif
+
+/* slab allocator carves nodes out of large chunks (slabs), the nodes
+ * inserted together are contiguous in memory. freed nodes are kept in their
+ * slab, a slab is released when it becomes empty and there are already
+ * 'XHASH_SLAB_KEEP' empty slabs. clear and destroy release slabs directly
+ * instead of freeing nodes one by one. it replaces 'XHASH_ENABLE_CACHE'.
+ * define 'XHASH_ENABLE_SLAB=1' to enable it. */
+#ifndef XHASH_ENABLE_SLAB
+#define XHASH_ENABLE_SLAB           0
+#endif
+
+/* dense mode keeps all nodes in an array (besides the buckets), iterations
+ * walk the array, they cost O(size) instead of O(bkt_size). it costs one
+ * pointer per element, node size doesn't change on 64-bit platform.
+ * define 'XHASH_ENABLE_DENSE=1' to enable it. */
+#ifndef XHASH_ENABLE_DENSE
+#define XHASH_ENABLE_DENSE          0
+#endif
+
+/* give every table a random seed in 'xhash_init'. with a seeded hash callback
+ * ('xhash_set_seeded_hash') the keys are hashed with it, so that keys which
+ * collide in one process (flooding one bucket) don't collide in another. a
+ * plain 'hash_cb' only gets its hash codes mixed with it, which re-spreads
+ * them over buckets, keys with equal 'hash_cb' codes still collide.
+ * see 'xhash_set_seed'. define 'XHASH_ENABLE_RANDOM_SEED=1' to enable it. */
+#ifndef XHASH_ENABLE_RANDOM_SEED
+#define XHASH_ENABLE_RANDOM_SEED    0
+#endif
+
+/* count puts, lookups, probes, resizes and node cache hits of every table,
+ * see 'xhash_stats'. the chain length histogram doesn't depend on it.
+ * define 'XHASH_ENABLE_STATS=1' to enable it. */
+#ifndef XHASH_ENABLE_STATS
+#define XHASH_ENABLE_STATS          0
+#endif
+
+/* run 'xhash_build' by multiple threads (pthreads), it's always single
+ * threaded without it. define 'XHASH_ENABLE_THREADS=1' to enable it. */
+#ifndef XHASH_ENABLE_THREADS
+#define XHASH_ENABLE_THREADS        0
+#endif
+
+/* a bloom filter of the hash codes in front of the buckets, lookups of absent
+ * elements can stop at it (see 'xhash_set_bloom'). it needs 'xbloom.c'.
+ * define 'XHASH_ENABLE_BLOOM=1' to enable it. */
+#ifndef XHASH_ENABLE_BLOOM
+#define XHASH_ENABLE_BLOOM          0
+#endif
+
+#endif
+
+#if XHASH_ENABLE_SLAB
+#undef  XHASH_ENABLE_CACHE
+#define XHASH_ENABLE_CACHE          0
+#endif
+
+#if XHASH_ENABLE_BLOOM
+#include "xbloom.h"
+#endif
+
+#ifndef XHASH_REHASH_STEP
+#define XHASH_REHASH_STEP           16 // buckets migrated per operation
+#endif
+
+#ifndef XHASH_BATCH_SIZE
+#define XHASH_BATCH_SIZE            32 // keys prefetched together in '*_many'
+#endif
+
+#ifndef XHASH_SLAB_SIZE
+#define XHASH_SLAB_SIZE             65536 // bytes, MUST be 2^n
+#endif
+
+#ifndef XHASH_SLAB_KEEP
+#define XHASH_SLAB_KEEP             1 // empty slabs kept as cache
+#endif
+
+#ifndef XHASH_BUILD_MAX_THREADS
+#define XHASH_BUILD_MAX_THREADS     64 // max threads of 'xhash_build'
+#endif
+
+#ifndef XHASH_STATS_CHAINS
+#define XHASH_STATS_CHAINS          16 // slots of the chain length histogram
 #endif
 
 typedef struct xhash        xhash_t;
 typedef struct xhash_node   xhash_node_t;
 typedef struct xhash_node*  xhash_iter_t;
+typedef struct xhash_slab   xhash_slab_t;
+typedef struct xhash_stats  xhash_stats_t;
 
 typedef void        (*xhash_destroy_cb)(void* pdata);
 typedef unsigned    (*xhash_hash_cb)(void* pdata);
+typedef unsigned    (*xhash_seeded_hash_cb)(void* pdata, unsigned long long seed);
 typedef int         (*xhash_equal_cb)(void* l, void* r);
+typedef void        (*xhash_foreach_cb)(void* pdata, void* ctx);
 
 struct xhash_node
 {
     struct xhash_node*  prev;
     struct xhash_node*  next;
     unsigned            hash;
+#if XHASH_ENABLE_DENSE
+    unsigned            index;      // position in 'dense'
+#endif
     // char data[0];
 };
 
+struct xhash_slab
+{
+    xhash_slab_t*       prev;
+    xhash_slab_t*       next;
+    xhash_node_t*       free;       // freed nodes, linked by 'next'
+    size_t              used;       // nodes in use
+    size_t              carved;     // nodes ever handed out, the rest is untouched
+    // nodes follow (aligned to 16)
+};
+
+struct xhash_stats
+{
+    /* counted when 'XHASH_ENABLE_STATS' is 1, otherwise they are 0 */
+    unsigned long long  puts;       // elements inserted
+    unsigned long long  hits;       // lookups which found the element
+    unsigned long long  misses;     // lookups which didn't
+    unsigned long long  probes;     // nodes visited by lookups
+    unsigned long long  max_probe;  // nodes visited by the longest lookup
+    unsigned long long  resizes;    // buckets expanded, shrunk or resized
+    unsigned long long  resize_ns;  // nanoseconds spent in resizing
+    unsigned long long  cache_hits; // nodes reused from the cache or a slab free list
+    /* filled by 'xhash_stats' */
+    size_t              size;
+    size_t              bkt_size;
+    size_t              max_chain;  // nodes of the longest bucket
+    size_t              chains[XHASH_STATS_CHAINS]; // buckets by number of nodes, the
+                                    // last one counts all the longer ones
+};
+
 struct xhash
 {
     xhash_hash_cb       hash_cb;
+    xhash_seeded_hash_cb seeded_hash_cb; // used instead of 'hash_cb' if not 'NULL'
     xhash_equal_cb      equal_cb;
     xhash_destroy_cb    destroy_cb;
     size_t              bkt_size;   // buckets size
     size_t              data_size;
     size_t              size;       // element (node) count
     size_t              loadfactor;
+    size_t              lowfactor;  // shrink buckets below it, 0 means never
+    int                 multi;      // multimap mode, equal elements are allowed
+    unsigned long long  seed;       // passed to 'seeded_hash_cb' or mixed into hash codes
+    void*               bulk;       // nodes of 'xhash_build', one allocation
+    size_t              bulk_size;  // bytes of 'bulk'
+#if XHASH_ENABLE_BLOOM
+    xbloom_t            bloom;      // prefilter of 'xhash_get', 'blocks' is 'NULL' if off
+    size_t              bloom_stale;// elements removed since the filter was built
+#endif
+#if XHASH_ENABLE_STATS
+    xhash_stats_t       stats;      // only the counters are kept up to date
+#endif
 #if XHASH_ENABLE_CACHE
     xhash_node_t*       cache;      // cache nodes
+#endif
+#if XHASH_ENABLE_SLAB
+    xhash_slab_t*       slabs;      // circular list, slabs which have free nodes first
+    size_t              slab_size;  // bytes of a slab, 2^n, slabs are aligned to it
+    size_t              slab_nodes; // nodes per slab
+    size_t              slab_empty; // number of empty slabs
+#endif
+#if XHASH_ENABLE_DENSE
+    size_t              dense_cap;
+    xhash_node_t**      dense;      // all nodes, 'size' of them are valid
+#endif
+#if XHASH_ENABLE_INCREMENTAL
+    size_t              rehash_idx; // next old bucket to migrate
+    size_t              old_bkt_size;
+    xhash_node_t**      old_buckets;// 'NULL' when no migration in flight
+#if XHASH_ENABLE_BLOOM
+    xbloom_t            bloom_next; // filled by migration, replaces 'bloom' then
+#endif
 #endif
     xhash_node_t**      buckets;
 };
@@ -83,10 +243,68 @@ void xhash_free(xhash_t* xh);
 void xhash_cache_free(xhash_t* xh);
 #endif
 
+/* copy the counters of 'xh' into 'out' (all 0 unless 'XHASH_ENABLE_STATS' is
+ * 1), then walk all buckets to fill the chain length histogram, it costs
+ * O(bkt_size + size). average probe length is 'probes / (hits + misses)', a
+ * bad hash function shows up as a long 'max_chain' with many empty buckets.
+ * the time of incremental rehash is not in 'resize_ns', it's spread over
+ * the operations after expanding. */
+void xhash_stats(xhash_t* xh, xhash_stats_t* out);
+#if XHASH_ENABLE_STATS
+/* set the counters of 'xh' to 0. */
+#define xhash_stats_reset(xh)   memset(&(xh)->stats, 0, sizeof(xhash_stats_t))
+#else
+#define xhash_stats_reset(xh)   ((void)0)
+#endif
+
 /* set loadfactor of 'xh', 'factor' is an interger which
  * standfor loadfactor percent. */
 #define xhash_set_loadfactor(xh, factor) \
                         (xh)->loadfactor = factor
+/* set low-water loadfactor percent of 'xh', buckets are halved in
+ * 'xhash_remove' when the load drops below it. 'factor' should be less than
+ * half of loadfactor, 0 (default) means never shrink. NOTE: shrinking changes
+ * the traversal order, don't remove elements while traversing unless
+ * 'XHASH_ENABLE_DENSE' is enabled. */
+#define xhash_set_lowfactor(xh, factor) \
+                        (xh)->lowfactor = factor
+/* set multimap mode of 'xh', it MUST be empty. in multimap mode, an element
+ * is always inserted, right after the elements equal to it, so that equal
+ * elements are adjacent in a bucket in insertion order, resizing keeps the
+ * order (see 'xhash_equal_range'). */
+#define xhash_set_multi(xh, on) (xh)->multi = (on)
+
+/* set the hash seed of 'xh', it MUST be empty. it's passed to the seeded hash
+ * callback if there is one, otherwise every hash code from 'hash_cb' is mixed
+ * with it (see 'xhash_hash_of'), 0 means no mixing. */
+#define xhash_set_seed(xh, s)   (xh)->seed = (s)
+/* set a hash callback which hashes the element with the seed of 'xh', it's
+ * used instead of 'hash_cb', 'xh' MUST be empty. only a seed which goes into
+ * the hash function makes collisions unpredictable, e.g. 'xhash_hash32'. */
+#define xhash_set_seeded_hash(xh, cb) \
+                        (xh)->seeded_hash_cb = (cb)
+#if XHASH_ENABLE_BLOOM
+/* turn on the negative-lookup prefilter of 'xh' with 'bits' bits per element
+ * (0 turns it off). it's a blocked bloom filter of the hash codes (see
+ * 'xbloom_t'), a lookup of an absent element ('xhash_get', 'xhash_count',
+ * etc.) usually stops at it, without touching buckets. it's sized for the
+ * buckets and rebuilt when they are resized (with XHASH_ENABLE_INCREMENTAL,
+ * the new one is filled by the migration, the old one is used until then),
+ * removed elements are left in it until the stale ones make it full, then
+ * it's rebuilt too. it pays off when most lookups miss and the filter stays
+ * in a nearer cache level than the buckets, otherwise it's an extra cache
+ * access (see 'test_bloom'). return 0 on success, -1 when out of memory. */
+int xhash_set_bloom(xhash_t* xh, unsigned bits);
+#endif
+/* return a random seed, it differs between calls and processes. */
+unsigned long long xhash_random_seed(void);
+
+/* make room for 'n' elements, so that no expanding happens before the size
+ * reaches 'n'. return 0 on success, -1 when out of memory. */
+int xhash_reserve(xhash_t* xh, size_t n);
+/* shrink buckets to fit the current size, and release the memory cached
+ * (cache nodes, empty slabs, unused dense array). */
+void xhash_shrink_to_fit(xhash_t* xh);
 
 /* return the number of elements. */
 #define xhash_size(xh)  ((xh)->size)
@@ -97,8 +315,14 @@ void xhash_cache_free(xhash_t* xh);
 
 /* return an iterator to the beginning. */
 xhash_iter_t xhash_begin(xhash_t* xh);
-/* return the next iterator of 'iter'. */
+/* return the next iterator of 'iter'. the traversal order doesn't
+ * change when buckets are being migrated (XHASH_ENABLE_INCREMENTAL).
+ * in dense mode (XHASH_ENABLE_DENSE), elements are visited from the last
+ * inserted one, removing 'iter' after getting its next is still safe. */
 xhash_iter_t xhash_iter_next(xhash_t* xh, xhash_iter_t iter);
+/* call 'cb' for every element with 'ctx', in no specific order.
+ * the table MUST not be modified in 'cb'. */
+void xhash_foreach(xhash_t* xh, xhash_foreach_cb cb, void* ctx);
 
 /* check whether an iterator is valid. */
 #define xhash_iter_valid(iter)  ((iter) != NULL)
@@ -106,22 +330,80 @@ xhash_iter_t xhash_iter_next(xhash_t* xh, xhash_iter_t iter);
 #define xhash_iter_data(iter)   ((void*)((iter) + 1))
 /* return an iterator of an element data. */
 #define xhash_data_iter(pdata)  ((xhash_iter_t)(pdata) - 1)
+/* return the stored hash code of 'iter', 'iter' MUST be valid. it can be
+ * passed to 'xhash_put_hashed' to move an element without rehashing
+ * (into a table which has the same seed). */
+#define xhash_iter_hash(iter)   ((iter)->hash)
+/* return the hash code of 'pdata' used by 'xh', that is the return value of
+ * 'seeded_hash_cb' with the seed of 'xh', or 'hash_cb' mixed with the seed.
+ * pass it to '*_hashed' functions. */
+#define xhash_hash_of(xh, pdata) ((xh)->seeded_hash_cb \
+                ? (xh)->seeded_hash_cb((void*)(pdata), (xh)->seed) \
+                : xhash_seeded_hash((xh)->hash_cb((void*)(pdata)), (xh)->seed))
 
 /* insert an element with specific data, return an iterator to
  * the inserted element, return 'NULL' when out of memory.
- * if the data is already exist, do nothing an return it's iterator. */
+ * if the data is already exist, do nothing an return it's iterator
+ * (unless in multimap mode, see 'xhash_set_multi'). */
 #define xhash_put(xh, pdata)    xhash_put_ex(xh, pdata, (xh)->data_size)
 /* similar to 'xhash_put', but useful when we don't want to init all 'data_size',
  * just init the <key> (which size is 'ksz'), and set <value> by yourself later. */
 xhash_iter_t xhash_put_ex(xhash_t* xh, const void* pdata, size_t ksz);
 /* find an element with specific data. return an iterator to
- * the element with specific data, return 'NULL' if not found. */
+ * the element with specific data, return 'NULL' if not found.
+ * in multimap mode, it's the first one of the equal elements. */
 xhash_iter_t xhash_get(xhash_t* xh, const void* pdata);
+
+/* similar to 'xhash_put', but use the caller-supplied 'hash' instead of
+ * calling 'hash_cb'. 'hash' MUST equal to 'xhash_hash_of(xh, pdata)', which is
+ * what 'hash_cb' returns if the seed of 'xh' is 0 and there is no seeded
+ * hash callback (default). */
+#define xhash_put_hashed(xh, pdata, hash) \
+                xhash_put_hashed_ex(xh, pdata, (xh)->data_size, hash)
+/* similar to 'xhash_put_ex', with a caller-supplied 'hash'. */
+xhash_iter_t xhash_put_hashed_ex(xhash_t* xh,
+            const void* pdata, size_t ksz, unsigned hash);
+/* similar to 'xhash_get', with a caller-supplied 'hash'. */
+xhash_iter_t xhash_get_hashed(xhash_t* xh, const void* pdata, unsigned hash);
+
+/* find 'n' elements, 'iters[i]' is set to the iterator of 'pdatas[i]' or 'NULL'.
+ * a batch of keys are hashed first, then their buckets and first nodes are
+ * prefetched before comparing, so the cache misses overlap across keys. */
+void xhash_get_many(xhash_t* xh, const void* const* pdatas,
+            size_t n, xhash_iter_t* iters);
+/* insert 'n' elements, the same as calling 'xhash_put' for each 'pdatas[i]'.
+ * 'iters' receives the return values, can be 'NULL'. */
+void xhash_put_many(xhash_t* xh, const void* const* pdatas,
+            size_t n, xhash_iter_t* iters);
+/* insert 'n' elements of array 'records' ('data_size' bytes each) into an
+ * empty 'xh' by 'nthreads' threads ('XHASH_ENABLE_THREADS', otherwise it's
+ * done by the calling thread only). buckets are sized for 'n' at once, all
+ * nodes come from one allocation, records are hashed in parallel, then
+ * grouped by bucket range and every range is linked by one thread without
+ * locks. the result is the same as calling 'xhash_put' for each record in
+ * order (a duplicate record is dropped unless in multimap mode, 'destroy_cb'
+ * is not called for it). 'hash_cb' and 'equal_cb' MUST be thread-safe.
+ * the memory of removed nodes is kept until 'xh' is cleared or destroyed.
+ * return 0 on success, -1 when 'xh' is not empty or out of memory. */
+int xhash_build(xhash_t* xh, const void* records, size_t n, int nthreads);
 /* remove an element at 'iter', 'iter' MUST be valid. */
 void xhash_remove(xhash_t* xh, xhash_iter_t iter);
 /* remove all elements (no cache) in 'xh'. */
 void xhash_clear(xhash_t* xh);
 
+/* find the elements equal to 'pdata' (multimap mode), they are adjacent.
+ * return an iterator to the first one, 'NULL' if not found. '*end' is set to
+ * the iterator after the last one, walk them with 'xhash_range_next':
+ *   for (iter = xhash_equal_range(xh, pdata, &end); iter != end;
+ *          iter = xhash_range_next(iter)) */
+xhash_iter_t xhash_equal_range(xhash_t* xh, const void* pdata, xhash_iter_t* end);
+/* return the next iterator of 'iter' in the range of 'xhash_equal_range'. */
+#define xhash_range_next(iter)  ((iter)->next)
+/* return the number of elements equal to 'pdata'. */
+size_t xhash_count(xhash_t* xh, const void* pdata);
+/* remove all elements equal to 'pdata', return the number of them. */
+size_t xhash_remove_all(xhash_t* xh, const void* pdata);
+
 /* find an element with specific data. return a pointer to the element
  * with specific data, return 'XHASH_INVALID_DATA' if not found.
  * the return value can call 'xhash_data_iter' to get it's iterator. */
@@ -213,4 +495,156 @@ static inline unsigned xhash_data_hash(const unsigned char *data, unsigned len)
     return h;
 }
 
+/* Seeded 64-bit hash functions, based on wyhash (wide multiply and fold).
+ * they are much faster than the above ones on long keys (16 or 32 bytes per
+ * step), and a secret seed makes collisions unpredictable. */
+
+#define XHASH_P0    0xa0761d6478bd642fULL
+#define XHASH_P1    0xe7037ed1a0b428dbULL
+#define XHASH_P2    0x8ebc6af09c88c6e3ULL
+#define XHASH_P3    0x589965cc75374cc3ULL
+
+/* multiply 'a' and 'b' to 128 bits, return the xor of high and low 64 bits. */
+static inline unsigned long long xhash_mum(unsigned long long a, unsigned long long b)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t)a * b;
+    return (unsigned long long)(r >> 64) ^ (unsigned long long)r;
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long long hi, lo = _umul128(a, b, &hi);
+    return hi ^ lo;
+#else
+    unsigned long long ha = a >> 32, la = (unsigned)a;
+    unsigned long long hb = b >> 32, lb = (unsigned)b;
+    unsigned long long rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    unsigned long long t = rl + (rm0 << 32), c = t < rl;
+    unsigned long long lo = t + (rm1 << 32);
+    c += lo < t;
+    return (rh + (rm0 >> 32) + (rm1 >> 32) + c) ^ lo;
+#endif
+}
+
+/* unaligned little-endian reads, so that hash codes don't depend on the
+ * byte order of the platform. */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define xhash_le64(v)   __builtin_bswap64(v)
+#define xhash_le32(v)   __builtin_bswap32(v)
+#else
+#define xhash_le64(v)   (v)
+#define xhash_le32(v)   (v)
+#endif
+static inline unsigned long long xhash_read64(const unsigned char* p)
+{
+    unsigned long long v;
+    memcpy(&v, p, 8);
+    return xhash_le64(v);
+}
+static inline unsigned long long xhash_read32(const unsigned char* p)
+{
+    unsigned v;
+    memcpy(&v, p, 4);
+    return xhash_le32(v);
+}
+
+/* hash 'len' bytes of 'data' with 'seed' to 64 bits. */
+static inline unsigned long long xhash_hash64(const void* data,
+                                size_t len, unsigned long long seed)
+{
+    const unsigned char* p = (const unsigned char*)data;
+    unsigned long long a, b;
+    size_t i = len;
+
+    seed ^= xhash_mum(seed ^ XHASH_P0, XHASH_P1);
+
+    if (len <= 16)
+    {
+        /* short keys, read them with (overlapped) 4 bytes loads */
+        if (len >= 4)
+        {
+            a = xhash_read32(p) << 32 | xhash_read32(p + ((len >> 3) << 2));
+            b = xhash_read32(p + len - 4) << 32
+                | xhash_read32(p + len - 4 - ((len >> 3) << 2));
+        }
+        else if (len > 0)
+        {
+            a = (unsigned long long)p[0] << 16
+                | (unsigned long long)p[len >> 1] << 8 | p[len - 1];
+            b = 0;
+        }
+        else
+        {
+            a = b = 0;
+        }
+    }
+    else
+    {
+        if (i > 32)
+        {
+            /* 32 bytes per step in two independent lanes */
+            unsigned long long seed1 = seed;
+
+            do
+            {
+                seed = xhash_mum(xhash_read64(p) ^ XHASH_P1,
+                            xhash_read64(p + 8) ^ seed);
+                seed1 = xhash_mum(xhash_read64(p + 16) ^ XHASH_P2,
+                            xhash_read64(p + 24) ^ seed1);
+                p += 32;
+                i -= 32;
+            }
+            while (i > 32);
+
+            seed ^= seed1;
+        }
+
+        while (i > 16)
+        {
+            seed = xhash_mum(xhash_read64(p) ^ XHASH_P1,
+                        xhash_read64(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+
+        /* the last 16 bytes, may overlap with the previous step */
+        a = xhash_read64(p + i - 16);
+        b = xhash_read64(p + i - 8);
+    }
+
+    return xhash_mum(xhash_mum(a ^ XHASH_P1, b ^ seed) ^ XHASH_P0 ^ len, XHASH_P3);
+}
+
+/* hash 'len' bytes of 'data' with 'seed' to 32 bits. */
+static inline unsigned xhash_hash32(const void* data,
+                                size_t len, unsigned long long seed)
+{
+    unsigned long long h = xhash_hash64(data, len, seed);
+    return (unsigned)(h ^ (h >> 32));
+}
+
+/* hash a NUL-terminated string with 'seed' to 32 bits. */
+static inline unsigned xhash_string_hash_seeded(const char* s, unsigned long long seed)
+{
+    return xhash_hash32(s, strlen(s), seed);
+}
+
+/* hash a 64-bit integer with 'seed' to 64 bits. */
+static inline unsigned long long xhash_int_hash64(unsigned long long k,
+                                unsigned long long seed)
+{
+    return xhash_mum(k ^ seed ^ XHASH_P0, XHASH_P1 ^ XHASH_P2);
+}
+
+/* mix hash code 'h' with 'seed', return 'h' if 'seed' is 0. it only
+ * re-spreads hash codes, equal 'h' are still equal after mixing. */
+static inline unsigned xhash_seeded_hash(unsigned h, unsigned long long seed)
+{
+    unsigned long long r;
+
+    if (!seed)
+        return h;
+
+    r = xhash_mum(h ^ seed, XHASH_P1);
+    return (unsigned)(r ^ (r >> 32));
+}
+
 #endif // _XHASH_H_
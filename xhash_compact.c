@@ -0,0 +1,317 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "xhash_compact.h"
+
+#define BLOCK_NODES         ((size_t)1 << XHASH_COMPACT_BLOCK_BITS)
+#define NODE_INDEX_MAX      ((unsigned)-1)
+
+/* return the node of index 'i', 'i' MUST be allocated. */
+#define node_at(xc, i) \
+            ((xhash_compact_node_t*)((xc)->blocks[(i) >> XHASH_COMPACT_BLOCK_BITS] \
+                + ((i) & (BLOCK_NODES - 1)) * (xc)->node_size))
+#define node_data(node)     ((void*)((node) + 1))
+#define data_node(pdata)    ((xhash_compact_node_t*)(pdata) - 1)
+
+/* return the index of a new node, return 0 when out of memory. */
+static unsigned node_alloc(xhash_compact_t* xc)
+{
+    unsigned i = xc->free_list;
+    size_t b;
+
+    if (i)
+    {
+        xc->free_list = node_at(xc, i)->next;
+        return i;
+    }
+
+    if (xc->node_used == NODE_INDEX_MAX)
+        return 0;
+
+    b = xc->node_used >> XHASH_COMPACT_BLOCK_BITS;
+
+    if (b == xc->blk_count)
+    {
+        /* the last block is full, allocate a new one */
+        if (b == xc->blk_cap)
+        {
+            size_t cap = xc->blk_cap ? xc->blk_cap * 2 : 16;
+            unsigned char** blocks = realloc(xc->blocks, sizeof(unsigned char*) * cap);
+
+            if (!blocks)
+                return 0;
+
+            xc->blocks = blocks;
+            xc->blk_cap = cap;
+        }
+
+        xc->blocks[b] = malloc(xc->node_size * BLOCK_NODES);
+        if (!xc->blocks[b])
+            return 0;
+
+        ++xc->blk_count;
+    }
+
+    return xc->node_used++;
+}
+
+static void node_free(xhash_compact_t* xc, unsigned i)
+{
+    node_at(xc, i)->next = xc->free_list;
+    xc->free_list = i;
+}
+
+static void buckets_expand(xhash_compact_t* xc)
+{
+    size_t new_size = xc->bkt_size << 1;
+    unsigned* new_buckets = malloc(sizeof(unsigned) * new_size);
+    xhash_compact_node_t* node;
+    unsigned* bucket;
+    unsigned i, next;
+    size_t b;
+
+    if (!new_buckets) return;
+
+    memset(new_buckets, 0, sizeof(unsigned) * new_size);
+
+    for (b = 0; b < xc->bkt_size; ++b)
+    {
+        for (i = xc->buckets[b]; i; i = next)
+        {
+            node = node_at(xc, i);
+            next = node->next;
+            /* push front, chain order is not kept */
+            bucket = &new_buckets[node->hash & (new_size - 1)];
+            node->next = *bucket;
+            *bucket = i;
+        }
+    }
+
+    free(xc->buckets);
+
+    xc->bkt_size = new_size;
+    xc->buckets = new_buckets;
+}
+
+static inline unsigned int align32pow2(unsigned int z)
+{
+    z -= 1;
+    z |= z >> 1;
+    z |= z >> 2;
+    z |= z >> 4;
+    z |= z >> 8;
+    z |= z >> 16;
+
+    return z + 1;
+}
+
+xhash_compact_t* xhash_compact_init(xhash_compact_t* xc, int size, size_t data_size,
+            xhash_hash_cb hash_cb, xhash_equal_cb equal_cb, xhash_destroy_cb destroy_cb)
+{
+    xc->hash_cb     = hash_cb;
+    xc->equal_cb    = equal_cb;
+    xc->destroy_cb  = destroy_cb;
+    xc->bkt_size    = size < XHASH_DEFAULT_SIZE ? XHASH_DEFAULT_SIZE : align32pow2(size);
+    xc->data_size   = data_size;
+    xc->node_size   = (sizeof(xhash_compact_node_t) + data_size + 7) & ~(size_t)7;
+    xc->size        = 0;
+    xc->loadfactor  = XHASH_DEFAULT_LOADFACTOR;
+    xc->node_used   = 1;
+    xc->free_list   = 0;
+    xc->blk_count   = 0;
+    xc->blk_cap     = 0;
+    xc->blocks      = NULL;
+    xc->buckets     = malloc(sizeof(unsigned) * xc->bkt_size);
+
+    if (xc->buckets)
+    {
+        memset(xc->buckets, 0, sizeof(unsigned) * xc->bkt_size);
+        return xc;
+    }
+
+    return NULL;
+}
+
+void xhash_compact_destroy(xhash_compact_t* xc)
+{
+    xhash_compact_clear(xc);
+    free(xc->blocks);
+    free(xc->buckets);
+}
+
+xhash_compact_t* xhash_compact_new(int size, size_t data_size, xhash_hash_cb hash_cb,
+            xhash_equal_cb equal_cb, xhash_destroy_cb destroy_cb)
+{
+    xhash_compact_t* xc = malloc(sizeof(xhash_compact_t));
+
+    if (xc)
+    {
+        if (xhash_compact_init(xc, size, data_size,
+                hash_cb, equal_cb, destroy_cb))
+            return xc;
+        free(xc);
+    }
+
+    return NULL;
+}
+
+void xhash_compact_free(xhash_compact_t* xc)
+{
+    if (xc)
+    {
+        xhash_compact_destroy(xc);
+        free(xc);
+    }
+}
+
+xhash_compact_iter_t xhash_compact_put_ex(xhash_compact_t* xc, const void* pdata, size_t ksz)
+{
+    unsigned hash = xc->hash_cb((void*)pdata);
+    unsigned* link = &xc->buckets[hash & (xc->bkt_size - 1)];
+    xhash_compact_node_t* node;
+    unsigned i;
+
+    while (*link)
+    {
+        node = node_at(xc, *link);
+
+        if (hash == node->hash
+            && xc->equal_cb(node_data(node), (void*)pdata))
+        {
+            return node_data(node);
+        }
+
+        link = &node->next;
+    }
+
+    i = node_alloc(xc);
+    if (!i)
+        return NULL;
+
+    /* 'link' is still valid, blocks never move */
+    node = node_at(xc, i);
+    node->next = 0;
+    node->hash = hash;
+    memcpy(node_data(node), pdata, ksz);
+    *link = i;
+
+    ++xc->size;
+
+    /* check loadfactor */
+    if (xc->size * 100 > xc->bkt_size * xc->loadfactor)
+        buckets_expand(xc);
+
+    return node_data(node);
+}
+
+xhash_compact_iter_t xhash_compact_get(xhash_compact_t* xc, const void* pdata)
+{
+    unsigned hash = xc->hash_cb((void*)pdata);
+    unsigned i = xc->buckets[hash & (xc->bkt_size - 1)];
+    xhash_compact_node_t* node;
+
+    while (i)
+    {
+        node = node_at(xc, i);
+
+        if (hash == node->hash
+            && xc->equal_cb(node_data(node), (void*)pdata))
+        {
+            return node_data(node);
+        }
+
+        i = node->next;
+    }
+
+    return NULL;
+}
+
+void xhash_compact_remove(xhash_compact_t* xc, xhash_compact_iter_t iter)
+{
+    xhash_compact_node_t* node = data_node(iter);
+    unsigned* link = &xc->buckets[node->hash & (xc->bkt_size - 1)];
+    unsigned i;
+
+    /* no 'prev' link, find the link which points to 'node' */
+    while (node_at(xc, *link) != node)
+        link = &node_at(xc, *link)->next;
+
+    i = *link;
+    *link = node->next;
+
+    if (xc->destroy_cb)
+        xc->destroy_cb(iter);
+
+    node_free(xc, i);
+
+    --xc->size;
+}
+
+void xhash_compact_clear(xhash_compact_t* xc)
+{
+    size_t b;
+    unsigned i;
+
+    if (xc->destroy_cb && xc->size)
+    {
+        for (b = 0; b < xc->bkt_size; ++b)
+        {
+            for (i = xc->buckets[b]; i; i = node_at(xc, i)->next)
+                xc->destroy_cb(node_data(node_at(xc, i)));
+        }
+    }
+
+    memset(xc->buckets, 0, sizeof(unsigned) * xc->bkt_size);
+
+    for (b = 0; b < xc->blk_count; ++b)
+        free(xc->blocks[b]);
+
+    xc->blk_count = 0;
+    xc->node_used = 1;
+    xc->free_list = 0;
+    xc->size = 0;
+}
+
+size_t xhash_compact_memory(xhash_compact_t* xc)
+{
+    return sizeof(unsigned) * xc->bkt_size
+        + sizeof(unsigned char*) * xc->blk_cap
+        + xc->node_size * BLOCK_NODES * xc->blk_count;
+}
+
+xhash_compact_iter_t xhash_compact_begin(xhash_compact_t* xc)
+{
+    size_t b;
+
+    for (b = 0; b < xc->bkt_size; ++b)
+    {
+        if (xc->buckets[b])
+            return node_data(node_at(xc, xc->buckets[b]));
+    }
+
+    return NULL;
+}
+
+xhash_compact_iter_t xhash_compact_iter_next(xhash_compact_t* xc, xhash_compact_iter_t iter)
+{
+    xhash_compact_node_t* node = data_node(iter);
+    size_t b;
+
+    if (node->next)
+        return node_data(node_at(xc, node->next));
+
+    b = node->hash & (xc->bkt_size - 1);
+
+    while (++b < xc->bkt_size)
+    {
+        if (xc->buckets[b])
+            return node_data(node_at(xc, xc->buckets[b]));
+    }
+
+    return NULL;
+}
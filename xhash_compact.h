@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#ifndef _XHASH_COMPACT_H_
+#define _XHASH_COMPACT_H_
+
+#include <stddef.h>
+
+#include "xhash.h"
+
+/*
+ * hash table with small per-element overhead, for lots of small elements.
+ * the logic is the same as 'xhash_t', but chains are singly linked by 32-bit
+ * node indexes instead of pointers, so a node header is only 8 bytes (next
+ * index and hash code) and a bucket is 4 bytes. nodes are allocated from
+ * blocks of 2^XHASH_COMPACT_BLOCK_BITS nodes, blocks never move, so data
+ * pointers are stable until the element is removed.
+ *
+ * removal re-walks the bucket to find the previous node, which is cheap
+ * since chains are short. at most 2^32 - 1 elements can be stored.
+ */
+
+#ifndef XHASH_COMPACT_BLOCK_BITS
+#define XHASH_COMPACT_BLOCK_BITS    10 // 1024 nodes per block
+#endif
+
+typedef struct xhash_compact        xhash_compact_t;
+typedef struct xhash_compact_node   xhash_compact_node_t;
+typedef void*                       xhash_compact_iter_t;
+
+struct xhash_compact_node
+{
+    unsigned            next;       // index of next node, 0 means none
+    unsigned            hash;
+    // char data[0];
+};
+
+struct xhash_compact
+{
+    xhash_hash_cb       hash_cb;
+    xhash_equal_cb      equal_cb;
+    xhash_destroy_cb    destroy_cb;
+    size_t              bkt_size;   // buckets size
+    size_t              data_size;
+    size_t              node_size;  // header + data, rounded up to 8
+    size_t              size;       // element (node) count
+    size_t              loadfactor;
+    unsigned            node_used;  // node indexes handed out, index 0 is never used
+    unsigned            free_list;  // freed nodes, linked by 'next'
+    size_t              blk_count;  // allocated blocks
+    size_t              blk_cap;    // capacity of 'blocks'
+    unsigned char**     blocks;
+    unsigned*           buckets;    // index of the first node, 0 means empty
+};
+
+/* initialize a 'xhash_compact_t', arguments are the same as 'xhash_init'. */
+xhash_compact_t* xhash_compact_init(xhash_compact_t* xc, int size, size_t data_size,
+            xhash_hash_cb hash_cb, xhash_equal_cb equal_cb, xhash_destroy_cb destroy_cb);
+/* destroy a 'xhash_compact_t' which has called 'xhash_compact_init'. */
+void xhash_compact_destroy(xhash_compact_t* xc);
+
+/* allocate memory and initialize a 'xhash_compact_t'. */
+xhash_compact_t* xhash_compact_new(int size, size_t data_size, xhash_hash_cb hash_cb,
+            xhash_equal_cb equal_cb, xhash_destroy_cb destroy_cb);
+/* release memory for a 'xhash_compact_t' which 'xhash_compact_new' returns. */
+void xhash_compact_free(xhash_compact_t* xc);
+
+/* set loadfactor of 'xc', 'factor' is an interger which
+ * standfor loadfactor percent. */
+#define xhash_compact_set_loadfactor(xc, factor) \
+                        (xc)->loadfactor = factor
+
+/* return the number of elements. */
+#define xhash_compact_size(xc)  ((xc)->size)
+/* check whether the container is empty. */
+#define xhash_compact_empty(xc) ((xc)->size == 0)
+/* return an iterator to the end. */
+#define xhash_compact_end(xc)   NULL
+
+/* return an iterator to the beginning. */
+xhash_compact_iter_t xhash_compact_begin(xhash_compact_t* xc);
+/* return the next iterator of 'iter'. */
+xhash_compact_iter_t xhash_compact_iter_next(xhash_compact_t* xc, xhash_compact_iter_t iter);
+
+/* check whether an iterator is valid. */
+#define xhash_compact_iter_valid(iter)  ((iter) != NULL)
+/* return a pointer pointed to the data of 'iter', 'iter' MUST be valid. */
+#define xhash_compact_iter_data(iter)   ((void*)(iter))
+
+/* insert an element with specific data, return an iterator to
+ * the inserted element, return 'NULL' when out of memory.
+ * if the data is already exist, do nothing an return it's iterator. */
+#define xhash_compact_put(xc, pdata) \
+                        xhash_compact_put_ex(xc, pdata, (xc)->data_size)
+/* similar to 'xhash_compact_put', but just init the <key> (which size is 'ksz'). */
+xhash_compact_iter_t xhash_compact_put_ex(xhash_compact_t* xc, const void* pdata, size_t ksz);
+/* find an element with specific data. return an iterator to
+ * the element with specific data, return 'NULL' if not found. */
+xhash_compact_iter_t xhash_compact_get(xhash_compact_t* xc, const void* pdata);
+/* remove an element at 'iter', 'iter' MUST be valid. */
+void xhash_compact_remove(xhash_compact_t* xc, xhash_compact_iter_t iter);
+/* remove all elements in 'xc', and release the node blocks. */
+void xhash_compact_clear(xhash_compact_t* xc);
+
+/* return the bytes allocated by 'xc' (buckets, blocks and block table). */
+size_t xhash_compact_memory(xhash_compact_t* xc);
+
+#endif // _XHASH_COMPACT_H_
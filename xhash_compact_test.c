@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "xhash_compact.h"
+
+#define RAND_SEED 123456
+
+typedef struct
+{
+    unsigned long long key;
+    int value;
+} kv_t;
+
+unsigned kv_hash(void* pdata)
+{
+    unsigned long long k = ((kv_t*)pdata)->key;
+    return xhash_improve_hash((unsigned)(k ^ (k >> 32)));
+}
+int kv_equal(void* l, void* r)
+{
+    return ((kv_t*)l)->key == ((kv_t*)r)->key;
+}
+
+void test()
+{
+    xhash_compact_t* xc = xhash_compact_new(-1, sizeof(kv_t), kv_hash, kv_equal, NULL);
+    xhash_compact_iter_t iter;
+    kv_t kv;
+    int i;
+
+    for (i = 0; i < 20; ++i)
+    {
+        kv.key = i * 1000000007ULL;
+        kv.value = i;
+        xhash_compact_put(xc, &kv);
+    }
+
+    // remove the odd ones
+    for (i = 1; i < 20; i += 2)
+    {
+        kv.key = i * 1000000007ULL;
+        xhash_compact_remove(xc, xhash_compact_get(xc, &kv));
+    }
+
+    // traverse
+    for (iter = xhash_compact_begin(xc);
+            iter != xhash_compact_end(xc); iter = xhash_compact_iter_next(xc, iter))
+    {
+        printf("%d ", ((kv_t*)xhash_compact_iter_data(iter))->value);
+    }
+    printf("\nsize %u\n", (unsigned)xhash_compact_size(xc));
+
+    xhash_compact_free(xc);
+}
+
+/* ------------------------------------- */
+// resident memory in KB, only available on linux
+static long rss_kb()
+{
+    FILE* fp = fopen("/proc/self/statm", "r");
+    long pages = 0;
+
+    if (fp)
+    {
+        if (fscanf(fp, "%*s %ld", &pages) != 1)
+            pages = 0;
+        fclose(fp);
+    }
+
+    return pages * 4; // assume 4KB page
+}
+static double elapsed(struct timespec* b, struct timespec* e)
+{
+    return (e->tv_sec - b->tv_sec) + (e->tv_nsec - b->tv_nsec) / 1e9;
+}
+static inline unsigned long long rand_key()
+{
+    return (unsigned long long)rand() << 32 | (unsigned)rand();
+}
+// 8-byte key and 4-byte value, the same data in 'xhash_t' and 'xhash_compact_t'
+void test_speed(int compact, int nvalues)
+{
+    xhash_t* xh = NULL;
+    xhash_compact_t* xc = NULL;
+    struct timespec begin, end;
+    long rss = rss_kb();
+    kv_t kv;
+    int count, i;
+
+    if (compact)
+        xc = xhash_compact_new(-1, sizeof(kv_t), kv_hash, kv_equal, NULL);
+    else
+        xh = xhash_new(-1, sizeof(kv_t), kv_hash, kv_equal, NULL);
+
+    srand(RAND_SEED);
+    timespec_get(&begin, TIME_UTC);
+    for (i = 0; i < nvalues; ++i)
+    {
+        kv.key = rand_key();
+        kv.value = i;
+        if (compact)
+            xhash_compact_put(xc, &kv);
+        else
+            xhash_put(xh, &kv);
+    }
+    timespec_get(&end, TIME_UTC);
+    rss = rss_kb() - rss;
+
+    printf("[%s] insert %d done, time %lfs, rss %.1lf bytes per entry",
+        compact ? "xhash_compact_t" : "xhash_t", nvalues,
+        elapsed(&begin, &end), rss * 1024.0 / nvalues);
+    if (compact)
+        printf(" (allocated %.1lf)", (double)xhash_compact_memory(xc) / nvalues);
+    printf(".\n");
+
+    srand(RAND_SEED);
+    timespec_get(&begin, TIME_UTC);
+    for (count = 0, i = 0; i < nvalues; ++i)
+    {
+        kv.key = rand_key();
+        if (compact ? xhash_compact_get(xc, &kv) != NULL
+                    : xhash_get(xh, &kv) != NULL)
+            ++count;
+    }
+    timespec_get(&end, TIME_UTC);
+
+    printf("[%s] search %d done, time %lfs, %.2lf Mops/s, found %d.\n",
+        compact ? "xhash_compact_t" : "xhash_t", nvalues, elapsed(&begin, &end),
+        nvalues / elapsed(&begin, &end) / 1e6, count);
+
+    if (compact)
+        xhash_compact_free(xc);
+    else
+        xhash_free(xh);
+}
+
+/* ------------------------------------- */
+
+int main(int argc, char** argv)
+{
+    // test();
+    // compact first, memory of nodes is given back to system when it's freed
+    test_speed(1, 5000000);
+    test_speed(0, 5000000);
+    return 0;
+}
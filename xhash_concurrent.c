@@ -0,0 +1,299 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "xhash_concurrent.h"
+
+#if defined(__GNUC__)
+#define stats_inc(p)    __atomic_fetch_add(p, 1, __ATOMIC_RELAXED)
+#else
+#define stats_inc(p)    (++*(p)) /* approximate */
+#endif
+
+/* all shards have the same seed (and hash callbacks), hash with shard 0. */
+#define hash_of(xc, pdata)  xhash_hash_of(&(xc)->shards[0].xh, pdata)
+
+/* use the high bits of hash code, the low bits are used by buckets of shard. */
+#define shard_of(xc, hash) \
+            (&(xc)->shards[(xc)->shard_bits \
+                ? (hash) >> (sizeof(unsigned) * 8 - (xc)->shard_bits) : 0])
+
+static inline void shard_wrlock(xhash_shard_t* s)
+{
+    if (pthread_rwlock_trywrlock(&s->lock) != 0)
+    {
+        pthread_rwlock_wrlock(&s->lock);
+        ++s->write_waits;
+    }
+    ++s->writes;
+}
+
+static inline void shard_rdlock(xhash_shard_t* s)
+{
+    if (pthread_rwlock_tryrdlock(&s->lock) != 0)
+    {
+        stats_inc(&s->read_waits);
+        pthread_rwlock_rdlock(&s->lock);
+    }
+}
+
+#if XHASH_ENABLE_INCREMENTAL
+/* 'xhash_get' migrates buckets in incremental mode, lookups hold the lock
+ * exclusively, but they are still reads. */
+static inline void shard_getlock(xhash_shard_t* s)
+{
+    if (pthread_rwlock_trywrlock(&s->lock) != 0)
+    {
+        stats_inc(&s->read_waits);
+        pthread_rwlock_wrlock(&s->lock);
+    }
+}
+#else
+#define shard_getlock(s)    shard_rdlock(s)
+#endif
+
+#define shard_unlock(s)     pthread_rwlock_unlock(&(s)->lock)
+
+xhash_concurrent_t* xhash_concurrent_init(xhash_concurrent_t* xc, int nshards,
+            int size, size_t data_size, xhash_hash_cb hash_cb,
+            xhash_equal_cb equal_cb, xhash_destroy_cb destroy_cb)
+{
+    size_t i, n;
+
+    if (nshards <= 0)
+        nshards = XHASH_CONCURRENT_DEFAULT_SHARDS;
+
+    xc->hash_cb     = hash_cb;
+    xc->data_size   = data_size;
+    xc->shard_bits  = 0;
+
+    while (((size_t)1 << xc->shard_bits) < (size_t)nshards)
+        ++xc->shard_bits;
+
+    n = xhash_concurrent_shards(xc);
+    xc->shards = malloc(sizeof(xhash_shard_t) * n);
+
+    if (!xc->shards) return NULL;
+
+    for (i = 0; i < n; ++i)
+    {
+        xhash_shard_t* s = &xc->shards[i];
+
+        if (!xhash_init(&s->xh, size, data_size,
+                hash_cb, equal_cb, destroy_cb))
+            break;
+
+        /* the shard is picked by the seeded hash code, it's the same in
+         * every shard */
+        xhash_set_seed(&s->xh, xc->shards[0].xh.seed);
+
+        pthread_rwlock_init(&s->lock, NULL);
+        s->writes       = 0;
+        s->read_waits   = 0;
+        s->write_waits  = 0;
+    }
+
+    if (i == n) return xc;
+
+    while (i-- > 0)
+    {
+        xhash_destroy(&xc->shards[i].xh);
+        pthread_rwlock_destroy(&xc->shards[i].lock);
+    }
+    free(xc->shards);
+
+    return NULL;
+}
+
+void xhash_concurrent_destroy(xhash_concurrent_t* xc)
+{
+    size_t i;
+
+    for (i = 0; i < xhash_concurrent_shards(xc); ++i)
+    {
+        xhash_destroy(&xc->shards[i].xh);
+        pthread_rwlock_destroy(&xc->shards[i].lock);
+    }
+
+    free(xc->shards);
+}
+
+xhash_concurrent_t* xhash_concurrent_new(int nshards, int size,
+            size_t data_size, xhash_hash_cb hash_cb,
+            xhash_equal_cb equal_cb, xhash_destroy_cb destroy_cb)
+{
+    xhash_concurrent_t* xc = malloc(sizeof(xhash_concurrent_t));
+
+    if (xc)
+    {
+        if (xhash_concurrent_init(xc, nshards, size, data_size,
+                hash_cb, equal_cb, destroy_cb))
+            return xc;
+        free(xc);
+    }
+
+    return NULL;
+}
+
+void xhash_concurrent_free(xhash_concurrent_t* xc)
+{
+    if (xc)
+    {
+        xhash_concurrent_destroy(xc);
+        free(xc);
+    }
+}
+
+void xhash_concurrent_set_seeded_hash(xhash_concurrent_t* xc,
+            xhash_seeded_hash_cb cb)
+{
+    size_t i;
+
+    for (i = 0; i < xhash_concurrent_shards(xc); ++i)
+        xhash_set_seeded_hash(&xc->shards[i].xh, cb);
+}
+
+size_t xhash_concurrent_size(xhash_concurrent_t* xc)
+{
+    size_t i, size = 0;
+
+    for (i = 0; i < xhash_concurrent_shards(xc); ++i)
+    {
+        shard_rdlock(&xc->shards[i]);
+        size += xhash_size(&xc->shards[i].xh);
+        shard_unlock(&xc->shards[i]);
+    }
+
+    return size;
+}
+
+int xhash_concurrent_put(xhash_concurrent_t* xc, const void* pdata)
+{
+    unsigned hash = hash_of(xc, pdata);
+    xhash_shard_t* s = shard_of(xc, hash);
+    xhash_iter_t iter;
+    size_t size;
+    int r;
+
+    shard_wrlock(s);
+
+    size = xhash_size(&s->xh);
+    iter = xhash_put_hashed(&s->xh, pdata, hash);
+    r = iter ? xhash_size(&s->xh) != size : -1;
+
+    shard_unlock(s);
+
+    return r;
+}
+
+int xhash_concurrent_get(xhash_concurrent_t* xc, const void* pdata, void* out)
+{
+    unsigned hash = hash_of(xc, pdata);
+    xhash_shard_t* s = shard_of(xc, hash);
+    xhash_iter_t iter;
+
+    shard_getlock(s);
+
+    iter = xhash_get_hashed(&s->xh, pdata, hash);
+    if (iter && out)
+        memcpy(out, xhash_iter_data(iter), xc->data_size);
+
+    shard_unlock(s);
+
+    return iter != NULL;
+}
+
+int xhash_concurrent_get_or_put(xhash_concurrent_t* xc,
+            const void* pdata, void* out)
+{
+    unsigned hash = hash_of(xc, pdata);
+    xhash_shard_t* s = shard_of(xc, hash);
+    xhash_iter_t iter;
+    size_t size;
+    int r;
+
+    /* most keys are found, try it under read lock first */
+    shard_getlock(s);
+
+    iter = xhash_get_hashed(&s->xh, pdata, hash);
+    if (iter && out)
+        memcpy(out, xhash_iter_data(iter), xc->data_size);
+
+    shard_unlock(s);
+
+    if (iter) return 0;
+
+    /* the key may be inserted by others after unlocking,
+     * 'xhash_put' returns the existing one in this case. */
+    shard_wrlock(s);
+
+    size = xhash_size(&s->xh);
+    iter = xhash_put_hashed(&s->xh, pdata, hash);
+    if (iter)
+    {
+        r = xhash_size(&s->xh) != size;
+        if (out)
+            memcpy(out, xhash_iter_data(iter), xc->data_size);
+    }
+    else
+    {
+        r = -1;
+    }
+
+    shard_unlock(s);
+
+    return r;
+}
+
+int xhash_concurrent_remove(xhash_concurrent_t* xc, const void* pdata)
+{
+    unsigned hash = hash_of(xc, pdata);
+    xhash_shard_t* s = shard_of(xc, hash);
+    xhash_iter_t iter;
+
+    shard_wrlock(s);
+
+    iter = xhash_get_hashed(&s->xh, pdata, hash);
+    if (iter)
+        xhash_remove(&s->xh, iter);
+
+    shard_unlock(s);
+
+    return iter != NULL;
+}
+
+void xhash_concurrent_clear(xhash_concurrent_t* xc)
+{
+    size_t i;
+
+    for (i = 0; i < xhash_concurrent_shards(xc); ++i)
+    {
+        shard_wrlock(&xc->shards[i]);
+        xhash_clear(&xc->shards[i].xh);
+        shard_unlock(&xc->shards[i]);
+    }
+}
+
+void xhash_concurrent_stats(xhash_concurrent_t* xc, xhash_shard_stats_t* stats)
+{
+    size_t i;
+
+    for (i = 0; i < xhash_concurrent_shards(xc); ++i)
+    {
+        xhash_shard_t* s = &xc->shards[i];
+
+        pthread_rwlock_rdlock(&s->lock);
+
+        stats[i].size           = xhash_size(&s->xh);
+        stats[i].bkt_size       = s->xh.bkt_size;
+        stats[i].writes         = s->writes;
+        stats[i].read_waits     = s->read_waits;
+        stats[i].write_waits    = s->write_waits;
+
+        pthread_rwlock_unlock(&s->lock);
+    }
+}
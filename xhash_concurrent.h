@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#ifndef _XHASH_CONCURRENT_H_
+#define _XHASH_CONCURRENT_H_
+
+#include <stddef.h>
+#include <pthread.h>
+
+#include "xhash.h"
+
+/*
+ * thread-safe hash table. the key space is split into 2^n shards by the
+ * high bits of hash code, every shard is a 'xhash_t' (which uses the low
+ * bits for buckets) guarded by its own reader-writer lock, and resizes
+ * on its own. iterators are not exposed since they are not safe after
+ * the shard is unlocked, element data is copied out instead.
+ *
+ * with XHASH_ENABLE_INCREMENTAL lookups migrate buckets, so the gets of a
+ * shard are serialized (they take the lock exclusively).
+ */
+
+#ifndef XHASH_CONCURRENT_DEFAULT_SHARDS
+#define XHASH_CONCURRENT_DEFAULT_SHARDS 16 // MUST be 2^n
+#endif
+
+typedef struct xhash_concurrent         xhash_concurrent_t;
+typedef struct xhash_shard              xhash_shard_t;
+typedef struct xhash_shard_stats        xhash_shard_stats_t;
+
+struct xhash_shard
+{
+    pthread_rwlock_t    lock;
+    size_t              writes;     // write operations
+    size_t              read_waits; // lock of a read is not acquired at first try
+    size_t              write_waits;// write lock is not acquired at first try
+    xhash_t             xh;
+    char                pad[64];    // keep shards in different cache lines
+};
+
+struct xhash_concurrent
+{
+    xhash_hash_cb       hash_cb;
+    size_t              data_size;
+    unsigned            shard_bits; // shard count is '1 << shard_bits'
+    xhash_shard_t*      shards;
+};
+
+struct xhash_shard_stats
+{
+    size_t              size;
+    size_t              bkt_size;
+    size_t              writes;
+    size_t              read_waits;
+    size_t              write_waits;
+};
+
+/* initialize a 'xhash_concurrent_t'.
+ * 'nshards' is the shard count, rounded up to 2^n, can be negative (means default).
+ * 'size' is the init bucket size of every shard, can be negative (means default).
+ * the callbacks have the same meaning as 'xhash_init'. */
+xhash_concurrent_t* xhash_concurrent_init(xhash_concurrent_t* xc, int nshards,
+            int size, size_t data_size, xhash_hash_cb hash_cb,
+            xhash_equal_cb equal_cb, xhash_destroy_cb destroy_cb);
+/* destroy a 'xhash_concurrent_t' which has called 'xhash_concurrent_init'. */
+void xhash_concurrent_destroy(xhash_concurrent_t* xc);
+
+/* allocate memory and initialize a 'xhash_concurrent_t'. */
+xhash_concurrent_t* xhash_concurrent_new(int nshards, int size,
+            size_t data_size, xhash_hash_cb hash_cb,
+            xhash_equal_cb equal_cb, xhash_destroy_cb destroy_cb);
+/* release memory for a 'xhash_concurrent_t' which 'xhash_concurrent_new' returns. */
+void xhash_concurrent_free(xhash_concurrent_t* xc);
+
+/* set the seeded hash callback of every shard (see 'xhash_set_seeded_hash'),
+ * 'xc' MUST be empty and not used by other threads. the shards share one
+ * seed (the random one of XHASH_ENABLE_RANDOM_SEED). */
+void xhash_concurrent_set_seeded_hash(xhash_concurrent_t* xc,
+            xhash_seeded_hash_cb cb);
+
+/* return the number of shards. */
+#define xhash_concurrent_shards(xc) ((size_t)1 << (xc)->shard_bits)
+
+/* return the number of elements (sum of all shards, not a snapshot). */
+size_t xhash_concurrent_size(xhash_concurrent_t* xc);
+
+/* insert an element with specific data. return 1 if inserted, 0 if
+ * the data is already exist (do nothing), -1 when out of memory. */
+int xhash_concurrent_put(xhash_concurrent_t* xc, const void* pdata);
+/* find an element with specific data, copy it into 'out' ('data_size' bytes,
+ * 'out' can be 'NULL'). return 1 if found, 0 if not found. */
+int xhash_concurrent_get(xhash_concurrent_t* xc, const void* pdata, void* out);
+/* find an element with specific data, insert 'pdata' if not found, these
+ * are done atomically. then copy the element into 'out' (can be 'NULL').
+ * return 1 if inserted, 0 if found, -1 when out of memory. */
+int xhash_concurrent_get_or_put(xhash_concurrent_t* xc,
+            const void* pdata, void* out);
+/* remove an element with specific data. return 1 if removed, 0 if not found. */
+int xhash_concurrent_remove(xhash_concurrent_t* xc, const void* pdata);
+/* remove all elements in 'xc'. */
+void xhash_concurrent_clear(xhash_concurrent_t* xc);
+
+/* get statistics of every shard, 'stats' MUST have 'xhash_concurrent_shards'
+ * elements. the wait counters show how much the shard lock is contended. */
+void xhash_concurrent_stats(xhash_concurrent_t* xc, xhash_shard_stats_t* stats);
+
+#endif // _XHASH_CONCURRENT_H_
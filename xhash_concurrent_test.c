@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "xhash_concurrent.h"
+
+#define RAND_SEED 123456
+
+typedef struct
+{
+    int key;
+    int value;
+} kv_t;
+
+unsigned kv_hash(void* pdata)
+{
+    return xhash_improve_hash((unsigned)((kv_t*)pdata)->key);
+}
+int kv_equal(void* l, void* r)
+{
+    return ((kv_t*)l)->key == ((kv_t*)r)->key;
+}
+
+void test()
+{
+    xhash_concurrent_t* xc = xhash_concurrent_new(4, -1, sizeof(kv_t),
+                                kv_hash, kv_equal, NULL);
+    xhash_shard_stats_t stats[4];
+    kv_t kv, out;
+    int i;
+
+    for (i = 0; i < 100; ++i)
+    {
+        kv.key = i;
+        kv.value = i * 10;
+        xhash_concurrent_put(xc, &kv);
+    }
+
+    kv.key = 42;
+    kv.value = -1;
+    // key already exist, get the old value
+    if (xhash_concurrent_get_or_put(xc, &kv, &out) == 0)
+        printf("key [42] found, value %d\n", out.value);
+
+    kv.key = 420;
+    if (xhash_concurrent_get_or_put(xc, &kv, &out) == 1)
+        printf("key [420] inserted, value %d\n", out.value);
+
+    kv.key = 7;
+    xhash_concurrent_remove(xc, &kv);
+    printf("size %u\n", (unsigned)xhash_concurrent_size(xc));
+
+    xhash_concurrent_stats(xc, stats);
+    for (i = 0; i < 4; ++i)
+        printf("shard %d, size %u\n", i, (unsigned)stats[i].size);
+
+    xhash_concurrent_free(xc);
+}
+
+/* ------------------------------------- */
+typedef struct
+{
+    xhash_concurrent_t* xc;
+    unsigned seed;
+    int nops;
+    int nkeys;
+    int write_percent;
+} worker_t;
+
+// xorshift32, every thread has its own state
+static inline unsigned rand_next(unsigned* s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 17;
+    *s ^= *s << 5;
+    return *s;
+}
+void* worker(void* arg)
+{
+    worker_t* w = arg;
+    kv_t kv;
+    int i;
+
+    for (i = 0; i < w->nops; ++i)
+    {
+        kv.key = rand_next(&w->seed) % (w->nkeys * 2);
+        kv.value = i;
+
+        if ((int)(rand_next(&w->seed) % 100) < w->write_percent)
+        {
+            if (i & 1)
+                xhash_concurrent_put(w->xc, &kv);
+            else
+                xhash_concurrent_remove(w->xc, &kv);
+        }
+        else
+        {
+            xhash_concurrent_get(w->xc, &kv, NULL);
+        }
+    }
+
+    return NULL;
+}
+static double elapsed(struct timespec* b, struct timespec* e)
+{
+    return (e->tv_sec - b->tv_sec) + (e->tv_nsec - b->tv_nsec) / 1e9;
+}
+void test_speed(int nshards, int nkeys, int nops)
+{
+    static const int write_percents[] = { 0, 10, 50 };
+    pthread_t threads[64];
+    worker_t workers[64];
+    struct timespec begin, end;
+    xhash_concurrent_t* xc;
+    kv_t kv;
+    int nthreads, i, w;
+
+    printf("[%d shards, %d keys, %d ops]\n", nshards, nkeys, nops);
+
+    for (w = 0; w < sizeof(write_percents) / sizeof(write_percents[0]); ++w)
+    {
+        for (nthreads = 1; nthreads <= 64; nthreads <<= 1)
+        {
+            xc = xhash_concurrent_new(nshards, -1, sizeof(kv_t),
+                    kv_hash, kv_equal, NULL);
+            for (i = 0; i < nkeys; ++i)
+            {
+                kv.key = i * 2;
+                kv.value = i;
+                xhash_concurrent_put(xc, &kv);
+            }
+
+            timespec_get(&begin, TIME_UTC);
+            for (i = 0; i < nthreads; ++i)
+            {
+                workers[i].xc = xc;
+                workers[i].seed = RAND_SEED + i;
+                workers[i].nops = nops / nthreads;
+                workers[i].nkeys = nkeys;
+                workers[i].write_percent = write_percents[w];
+                pthread_create(&threads[i], NULL, worker, &workers[i]);
+            }
+            for (i = 0; i < nthreads; ++i)
+                pthread_join(threads[i], NULL);
+            timespec_get(&end, TIME_UTC);
+
+            printf("write %2d%%, threads %2d, time %lfs, %.2lf Mops/s.\n",
+                write_percents[w], nthreads, elapsed(&begin, &end),
+                nops / elapsed(&begin, &end) / 1e6);
+
+            xhash_concurrent_free(xc);
+        }
+    }
+}
+
+/* ------------------------------------- */
+
+int main(int argc, char** argv)
+{
+    // test();
+    // one shard is the same as a global lock
+    test_speed(1, 1000000, 8000000);
+    test_speed(64, 1000000, 8000000);
+    return 0;
+}
@@ -0,0 +1,370 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "xhash_flat.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define XHASH_FLAT_USE_SSE2 1
+#else
+#define XHASH_FLAT_USE_SSE2 0
+#endif
+
+/* control byte: 'empty' and 'deleted' have the high bit set,
+ * a full slot stores the low 7 bits of the element's hash. */
+#define CTRL_EMPTY          ((signed char)-128)
+#define CTRL_DELETED        ((signed char)-2)
+
+#define ctrl_is_full(c)     ((c) >= 0)
+
+/* 'h1' selects the first probed group, 'h2' is stored in control byte. */
+#define hash_h1(h)          ((h) >> 7)
+#define hash_h2(h)          ((signed char)((h) & 0x7f))
+
+#define slot_at(xf, i)      ((xf)->slots + (xf)->data_size * (i))
+#define max_growth(cap)     ((cap) - ((cap) >> 3)) /* 7/8 of capacity */
+
+/* return a bitmask of the control bytes in group 'g' which equal to 'h2'. */
+static inline unsigned group_match(const signed char* g, signed char h2)
+{
+#if XHASH_FLAT_USE_SSE2
+    __m128i ctrl = _mm_loadu_si128((const __m128i*)g);
+    return (unsigned)_mm_movemask_epi8(
+                _mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl));
+#else
+    unsigned mask = 0;
+    int i;
+
+    for (i = 0; i < XHASH_FLAT_GROUP_WIDTH; ++i)
+    {
+        if (g[i] == h2)
+            mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+/* return a bitmask of the 'empty' or 'deleted' control bytes in group 'g'. */
+static inline unsigned group_match_free(const signed char* g)
+{
+#if XHASH_FLAT_USE_SSE2
+    /* the high bit is set only in 'empty' and 'deleted' */
+    return (unsigned)_mm_movemask_epi8(
+                _mm_loadu_si128((const __m128i*)g));
+#else
+    unsigned mask = 0;
+    int i;
+
+    for (i = 0; i < XHASH_FLAT_GROUP_WIDTH; ++i)
+    {
+        if (!ctrl_is_full(g[i]))
+            mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+#define group_match_empty(g)    group_match(g, CTRL_EMPTY)
+
+/* return the index of the lowest set bit, 'mask' MUST not be 0. */
+static inline unsigned mask_first(unsigned mask)
+{
+#if defined(__GNUC__)
+    return (unsigned)__builtin_ctz(mask);
+#else
+    unsigned i = 0;
+
+    while (!(mask & 1))
+    {
+        mask >>= 1;
+        ++i;
+    }
+    return i;
+#endif
+}
+
+/* find the first 'empty' or 'deleted' slot along the probe sequence of 'hash'.
+ * groups are probed in triangular order, which visits all groups
+ * when the group count is 2^n. */
+static size_t find_free_slot(const signed char* ctrls,
+            size_t capacity, unsigned hash)
+{
+    size_t gmask = capacity / XHASH_FLAT_GROUP_WIDTH - 1;
+    size_t g = hash_h1(hash) & gmask;
+    size_t step = 0;
+    unsigned mask;
+
+    while (1)
+    {
+        mask = group_match_free(ctrls + g * XHASH_FLAT_GROUP_WIDTH);
+        if (mask)
+            return g * XHASH_FLAT_GROUP_WIDTH + mask_first(mask);
+
+        g = (g + ++step) & gmask;
+    }
+}
+
+static int slots_rehash(xhash_flat_t* xf)
+{
+    size_t new_cap = xf->capacity;
+    size_t i, j;
+    signed char* new_ctrls;
+    unsigned char* new_slots;
+
+    /* grow when more than half of 'max_growth' is used by live elements,
+     * otherwise the table is full of 'deleted', just drop them. */
+    if (xf->size * 2 >= max_growth(xf->capacity))
+        new_cap <<= 1;
+
+    new_ctrls = malloc(new_cap + new_cap * xf->data_size);
+    if (!new_ctrls) return -1;
+
+    new_slots = (unsigned char*)(new_ctrls + new_cap);
+    memset(new_ctrls, CTRL_EMPTY, new_cap);
+
+    for (i = 0; i < xf->capacity; ++i)
+    {
+        if (ctrl_is_full(xf->ctrls[i]))
+        {
+            unsigned hash = xf->hash_cb(slot_at(xf, i));
+
+            j = find_free_slot(new_ctrls, new_cap, hash);
+            new_ctrls[j] = hash_h2(hash);
+            memcpy(new_slots + xf->data_size * j,
+                    slot_at(xf, i), xf->data_size);
+        }
+    }
+
+    free(xf->ctrls);
+
+    xf->capacity    = new_cap;
+    xf->growth_left = max_growth(new_cap) - xf->size;
+    xf->ctrls       = new_ctrls;
+    xf->slots       = new_slots;
+    return 0;
+}
+
+static inline unsigned int align32pow2(unsigned int z)
+{
+    z -= 1;
+    z |= z >> 1;
+    z |= z >> 2;
+    z |= z >> 4;
+    z |= z >> 8;
+    z |= z >> 16;
+
+    return z + 1;
+}
+
+xhash_flat_t* xhash_flat_init(xhash_flat_t* xf, int size, size_t data_size,
+            xhash_hash_cb hash_cb, xhash_equal_cb equal_cb,
+            xhash_destroy_cb destroy_cb)
+{
+    xf->hash_cb     = hash_cb;
+    xf->equal_cb    = equal_cb;
+    xf->destroy_cb  = destroy_cb;
+    xf->capacity    = size < XHASH_FLAT_DEFAULT_SIZE ? XHASH_FLAT_DEFAULT_SIZE : align32pow2(size);
+    xf->data_size   = data_size;
+    xf->size        = 0;
+    xf->growth_left = max_growth(xf->capacity);
+    xf->ctrls       = malloc(xf->capacity + xf->capacity * data_size);
+
+    if (xf->ctrls)
+    {
+        xf->slots = (unsigned char*)(xf->ctrls + xf->capacity);
+        memset(xf->ctrls, CTRL_EMPTY, xf->capacity);
+        return xf;
+    }
+
+    return NULL;
+}
+
+void xhash_flat_destroy(xhash_flat_t* xf)
+{
+    xhash_flat_clear(xf);
+    free(xf->ctrls);
+}
+
+xhash_flat_t* xhash_flat_new(int size, size_t data_size, xhash_hash_cb hash_cb,
+            xhash_equal_cb equal_cb, xhash_destroy_cb destroy_cb)
+{
+    xhash_flat_t* xf = malloc(sizeof(xhash_flat_t));
+
+    if (xf)
+    {
+        if (xhash_flat_init(xf, size, data_size,
+                hash_cb, equal_cb, destroy_cb))
+            return xf;
+        free(xf);
+    }
+
+    return NULL;
+}
+
+void xhash_flat_free(xhash_flat_t* xf)
+{
+    if (xf)
+    {
+        xhash_flat_clear(xf);
+        free(xf->ctrls);
+        free(xf);
+    }
+}
+
+xhash_flat_iter_t xhash_flat_put_ex(xhash_flat_t* xf, const void* pdata, size_t ksz)
+{
+    unsigned hash = xf->hash_cb((void*)pdata);
+    signed char h2 = hash_h2(hash);
+    size_t gmask = xf->capacity / XHASH_FLAT_GROUP_WIDTH - 1;
+    size_t g = hash_h1(hash) & gmask;
+    size_t step = 0;
+    size_t i;
+    signed char* ctrl;
+    unsigned mask;
+
+    while (1)
+    {
+        ctrl = xf->ctrls + g * XHASH_FLAT_GROUP_WIDTH;
+        mask = group_match(ctrl, h2);
+
+        while (mask)
+        {
+            i = g * XHASH_FLAT_GROUP_WIDTH + mask_first(mask);
+            if (xf->equal_cb(slot_at(xf, i), (void*)pdata))
+                return slot_at(xf, i);
+            mask &= mask - 1;
+        }
+
+        /* an 'empty' slot ends the probe sequence */
+        if (group_match_empty(ctrl))
+            break;
+
+        g = (g + ++step) & gmask;
+    }
+
+    i = find_free_slot(xf->ctrls, xf->capacity, hash);
+
+    if (xf->growth_left == 0 && xf->ctrls[i] == CTRL_EMPTY)
+    {
+        if (slots_rehash(xf) != 0)
+            return NULL;
+        i = find_free_slot(xf->ctrls, xf->capacity, hash);
+    }
+
+    /* reuse a 'deleted' slot don't consume growth */
+    if (xf->ctrls[i] == CTRL_EMPTY)
+        --xf->growth_left;
+
+    xf->ctrls[i] = h2;
+    memcpy(slot_at(xf, i), pdata, ksz);
+
+    ++xf->size;
+
+    return slot_at(xf, i);
+}
+
+xhash_flat_iter_t xhash_flat_get(xhash_flat_t* xf, const void* pdata)
+{
+    unsigned hash = xf->hash_cb((void*)pdata);
+    signed char h2 = hash_h2(hash);
+    size_t gmask = xf->capacity / XHASH_FLAT_GROUP_WIDTH - 1;
+    size_t g = hash_h1(hash) & gmask;
+    size_t step = 0;
+    size_t i;
+    signed char* ctrl;
+    unsigned mask;
+
+    while (1)
+    {
+        ctrl = xf->ctrls + g * XHASH_FLAT_GROUP_WIDTH;
+        mask = group_match(ctrl, h2);
+
+        while (mask)
+        {
+            i = g * XHASH_FLAT_GROUP_WIDTH + mask_first(mask);
+            if (xf->equal_cb(slot_at(xf, i), (void*)pdata))
+                return slot_at(xf, i);
+            mask &= mask - 1;
+        }
+
+        if (group_match_empty(ctrl))
+            return NULL;
+
+        g = (g + ++step) & gmask;
+    }
+}
+
+void xhash_flat_remove(xhash_flat_t* xf, xhash_flat_iter_t iter)
+{
+    size_t i = ((unsigned char*)iter - xf->slots) / xf->data_size;
+
+    if (xf->destroy_cb)
+        xf->destroy_cb(iter);
+
+    /* if this group still has an 'empty' slot, no probe sequence goes
+     * through it, so the slot can be 'empty' instead of 'deleted'. */
+    if (group_match_empty(xf->ctrls
+            + (i & ~(size_t)(XHASH_FLAT_GROUP_WIDTH - 1))))
+    {
+        xf->ctrls[i] = CTRL_EMPTY;
+        ++xf->growth_left;
+    }
+    else
+    {
+        xf->ctrls[i] = CTRL_DELETED;
+    }
+
+    --xf->size;
+}
+
+void xhash_flat_clear(xhash_flat_t* xf)
+{
+    size_t i;
+
+    if (xhash_flat_empty(xf)) return;
+
+    if (xf->destroy_cb)
+    {
+        for (i = 0; i < xf->capacity; ++i)
+        {
+            if (ctrl_is_full(xf->ctrls[i]))
+                xf->destroy_cb(slot_at(xf, i));
+        }
+    }
+
+    memset(xf->ctrls, CTRL_EMPTY, xf->capacity);
+
+    xf->size = 0;
+    xf->growth_left = max_growth(xf->capacity);
+}
+
+xhash_flat_iter_t xhash_flat_begin(xhash_flat_t* xf)
+{
+    size_t i;
+
+    for (i = 0; i < xf->capacity; ++i)
+    {
+        if (ctrl_is_full(xf->ctrls[i]))
+            return slot_at(xf, i);
+    }
+
+    return NULL;
+}
+
+xhash_flat_iter_t xhash_flat_iter_next(xhash_flat_t* xf, xhash_flat_iter_t iter)
+{
+    size_t i = ((unsigned char*)iter - xf->slots) / xf->data_size;
+
+    while (++i < xf->capacity)
+    {
+        if (ctrl_is_full(xf->ctrls[i]))
+            return slot_at(xf, i);
+    }
+
+    return NULL;
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#ifndef _XHASH_FLAT_H_
+#define _XHASH_FLAT_H_
+
+#include <stddef.h>
+
+#include "xhash.h"
+
+/*
+ * open-addressing hash table, logic based on google's swiss table.
+ * elements are stored inline in a slot array, every slot has one control
+ * byte which is 'empty', 'deleted' or the low 7 bits of the element's hash.
+ * control bytes are grouped by 16, a lookup matches a whole group at once
+ * (with SSE2 when available), so most lookups touch only one group.
+ *
+ * +---+---+---+---+---+---+---+---+
+ * | c | c |...| c | c | c |...| c | (control bytes, 16 per group)
+ * +---+---+---+---+---+---+---+---+
+ * | s | s |...| s | s | s |...| s | (slots, 'data_size' bytes each)
+ * +---+---+---+---+---+---+---+---+
+ *     group 0     |     group 1
+ */
+
+#ifdef HAVE_XCONFIG_H
+#include "xconfig.h"
+#else
+
+#ifndef XHASH_FLAT_DEFAULT_SIZE
+#define XHASH_FLAT_DEFAULT_SIZE     64 // MUST be 2^n and >= 16
+#endif
+
+#endif
+
+#define XHASH_FLAT_GROUP_WIDTH      16
+
+typedef struct xhash_flat   xhash_flat_t;
+typedef void*               xhash_flat_iter_t;
+
+struct xhash_flat
+{
+    xhash_hash_cb       hash_cb;
+    xhash_equal_cb      equal_cb;
+    xhash_destroy_cb    destroy_cb;
+    size_t              capacity;   // slot count, 2^n
+    size_t              data_size;
+    size_t              size;       // element count
+    size_t              growth_left;// slots can be filled before rehash
+    signed char*        ctrls;      // control bytes, 'capacity' bytes
+    unsigned char*      slots;      // follow 'ctrls' in the same memory block
+};
+
+/* initialize a 'xhash_flat_t'.
+ * 'size' is the init slot count, can be negative (means default).
+ * the callbacks have the same meaning as 'xhash_init'. */
+xhash_flat_t* xhash_flat_init(xhash_flat_t* xf, int size, size_t data_size,
+            xhash_hash_cb hash_cb, xhash_equal_cb equal_cb, xhash_destroy_cb destroy_cb);
+/* destroy a 'xhash_flat_t' which has called 'xhash_flat_init'. */
+void xhash_flat_destroy(xhash_flat_t* xf);
+
+/* allocate memory and initialize a 'xhash_flat_t'. */
+xhash_flat_t* xhash_flat_new(int size, size_t data_size, xhash_hash_cb hash_cb,
+            xhash_equal_cb equal_cb, xhash_destroy_cb destroy_cb);
+/* release memory for a 'xhash_flat_t' which 'xhash_flat_new' returns. */
+void xhash_flat_free(xhash_flat_t* xf);
+
+/* return the number of elements. */
+#define xhash_flat_size(xf)     ((xf)->size)
+/* check whether the container is empty. */
+#define xhash_flat_empty(xf)    ((xf)->size == 0)
+/* return an iterator to the end. */
+#define xhash_flat_end(xf)      NULL
+
+/* return an iterator to the beginning. */
+xhash_flat_iter_t xhash_flat_begin(xhash_flat_t* xf);
+/* return the next iterator of 'iter'. */
+xhash_flat_iter_t xhash_flat_iter_next(xhash_flat_t* xf, xhash_flat_iter_t iter);
+
+/* check whether an iterator is valid. */
+#define xhash_flat_iter_valid(iter) ((iter) != NULL)
+/* return a pointer pointed to the data of 'iter', 'iter' MUST be valid. */
+#define xhash_flat_iter_data(iter)  ((void*)(iter))
+
+/* insert an element with specific data, return an iterator to
+ * the inserted element, return 'NULL' when out of memory.
+ * if the data is already exist, do nothing an return it's iterator.
+ * NOTE: elements are moved when table grows, so all iterators
+ * (and data pointers) are invalid after a insertion. */
+#define xhash_flat_put(xf, pdata)   xhash_flat_put_ex(xf, pdata, (xf)->data_size)
+/* similar to 'xhash_flat_put', but just init the <key> (which size is 'ksz'). */
+xhash_flat_iter_t xhash_flat_put_ex(xhash_flat_t* xf, const void* pdata, size_t ksz);
+/* find an element with specific data. return an iterator to
+ * the element with specific data, return 'NULL' if not found. */
+xhash_flat_iter_t xhash_flat_get(xhash_flat_t* xf, const void* pdata);
+/* remove an element at 'iter', 'iter' MUST be valid. */
+void xhash_flat_remove(xhash_flat_t* xf, xhash_flat_iter_t iter);
+/* remove all elements in 'xf'. */
+void xhash_flat_clear(xhash_flat_t* xf);
+
+#endif // _XHASH_FLAT_H_
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "xhash_flat.h"
+
+#define RAND_SEED 123456
+
+typedef struct
+{
+    char key[16];
+    int value;
+    // ...
+} mystruct_t;
+
+unsigned mystruct_hash(void* pdata)
+{
+    return xhash_string_hash(((mystruct_t*)pdata)->key);
+}
+int mystruct_equal(void* l, void* r)
+{
+    return strcmp(((mystruct_t*)l)->key, ((mystruct_t*)r)->key) == 0;
+}
+
+void test()
+{
+    xhash_flat_t* xf = xhash_flat_new(-1, sizeof(mystruct_t),
+                        mystruct_hash, mystruct_equal, NULL);
+    mystruct_t  myst;
+    mystruct_t* pmyst;
+    xhash_flat_iter_t iter;
+    int i;
+
+#define BEGIN_VALUE   311111800
+#define END_VALUE     311112000
+    // put some elements
+    for (i = BEGIN_VALUE; i < END_VALUE; ++i)
+    {
+        sprintf(myst.key, "%d", i);
+        myst.value = i;
+        xhash_flat_put(xf, &myst);
+    }
+    printf("size %u, capacity %u\n",
+        (unsigned)xhash_flat_size(xf), (unsigned)xf->capacity);
+
+    // remove some elements
+    for (i = BEGIN_VALUE + 111; i < BEGIN_VALUE + 120; ++i)
+    {
+        sprintf(myst.key, "%d", i);
+        xhash_flat_remove(xf, xhash_flat_get(xf, &myst));
+    }
+
+    // find all elements
+    for (i = BEGIN_VALUE; i < END_VALUE; ++i)
+    {
+        sprintf(myst.key, "%d", i);
+
+        pmyst = xhash_flat_get(xf, &myst);
+        if (pmyst)
+            ;//printf("found key = \"%s\", value = %d\n", pmyst->key, pmyst->value);
+        else
+            printf("key \"%s\" not found!\n", myst.key);
+    }
+#undef BEGIN_VALUE
+#undef END_VALUE
+
+    // traverse
+    for (iter = xhash_flat_begin(xf);
+            iter != xhash_flat_end(xf); iter = xhash_flat_iter_next(xf, iter))
+    {
+        printf("%d ", ((mystruct_t*)xhash_flat_iter_data(iter))->value);
+    }
+    printf("\n");
+
+    xhash_flat_free(xf);
+}
+
+/* ------------------------------------- */
+// random an integer
+static inline int rand_int()
+{
+    return rand() << 16 | rand() & 0xffff;
+}
+unsigned int_hash(void* v)
+{
+    return *(unsigned*)v;
+}
+int int_equal(void* l, void* r)
+{
+    return *(int*)l == *(int*)r;
+}
+void test_speed(int nvalues)
+{
+    xhash_flat_t* xf = xhash_flat_new(-1, sizeof(int), int_hash, int_equal, NULL);
+    clock_t begin, end;
+    int value, count, i;
+
+    srand(RAND_SEED);
+    // generate 'nvalues' random integer and put into 'xf'
+    begin = clock();
+    for (i = 0; i < nvalues; ++i)
+    {
+        value = rand_int();
+        if (!xhash_flat_put(xf, &value))
+        {
+            printf("out of memory when insert %d value.\n", i);
+            break;
+        }
+    }
+    end = clock();
+    printf("insert %d random integer done, capacity %u, values %u, time %lfs.\n",
+            nvalues, (unsigned)xf->capacity, (unsigned)xhash_flat_size(xf), (double)(end - begin) / CLOCKS_PER_SEC);
+
+    // reset the same seed to get the same series number
+    srand(RAND_SEED);
+    // search time test
+    begin = clock();
+    for (count = 0, i = 0; i < nvalues; ++i)
+    {
+        value = rand_int();
+        if (xhash_flat_get(xf, &value))
+            ++count;
+    }
+    end = clock();
+    printf("search %d random integer done, time %lfs, found %d.\n",
+            nvalues, (double)(end - begin) / CLOCKS_PER_SEC, count);
+
+    // reset the same seed to get the same series number
+    srand(RAND_SEED);
+    // remove time test
+    begin = clock();
+    for (count = 0, i = 0; i < nvalues; ++i)
+    {
+        value = rand_int();
+        xhash_flat_iter_t iter = xhash_flat_get(xf, &value);
+        if (iter)
+            xhash_flat_remove(xf, iter);
+        else
+            ++count;
+    }
+    end = clock();
+    printf("remove %d random integer done, time %lfs, %d not found.\n",
+            nvalues, (double)(end - begin) / CLOCKS_PER_SEC, count);
+
+    printf("press any key to continue...\n");
+    getchar();
+    xhash_flat_free(xf);
+}
+
+/* ------------------------------------- */
+
+int main(int argc, char** argv)
+{
+    // test();
+    test_speed(5000000);
+    return 0;
+}
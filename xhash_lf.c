@@ -0,0 +1,495 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "xhash_lf.h"
+
+#if defined(__GNUC__)
+#define load_relaxed(p)         __atomic_load_n(p, __ATOMIC_RELAXED)
+#define load_acquire(p)         __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define store_relaxed(p, v)     __atomic_store_n(p, v, __ATOMIC_RELAXED)
+#define store_release(p, v)     __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#define fence_seq_cst()         __atomic_thread_fence(__ATOMIC_SEQ_CST)
+/* 'expected' is an lvalue, it's updated on failure */
+#define cas_acquire(p, expected, desired) \
+            __atomic_compare_exchange_n(p, &(expected), desired, \
+                0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+/* all loaded fields are pointer sized. volatile loads of them are atomic and
+ * acquire ('/volatile:ms', the default on x86 and x64), stores are ordered
+ * after the previous accesses by the compiler barrier, the cpu doesn't
+ * reorder stores with older loads or stores. */
+#define load_relaxed(p)         (*(void* volatile*)(p))
+#define load_acquire(p)         (*(void* volatile*)(p))
+#define store_relaxed(p, v)     (*(p) = (v))
+#define store_release(p, v)     (_ReadWriteBarrier(), *(p) = (v))
+#define fence_seq_cst()         (_ReadWriteBarrier(), _mm_mfence(), _ReadWriteBarrier())
+/* only used on 'int' which has the size of 'long', it's a full barrier */
+#define cas_acquire(p, expected, desired) \
+            (_InterlockedCompareExchange((volatile long*)(p), \
+                (long)(desired), (long)(expected)) == (long)(expected))
+#else
+#error "xhash_lf needs GCC atomic builtins, or MSVC on x86/x64"
+#endif
+
+/* the writer lock */
+#ifdef _WIN32
+#define lock_init(l)            InitializeSRWLock(l)
+#define lock_destroy(l)         ((void)(l))
+#define lock_acquire(l)         AcquireSRWLockExclusive(l)
+#define lock_release(l)         ReleaseSRWLockExclusive(l)
+#else
+#define lock_init(l)            pthread_mutex_init(l, NULL)
+#define lock_destroy(l)         pthread_mutex_destroy(l)
+#define lock_acquire(l)         pthread_mutex_lock(l)
+#define lock_release(l)         pthread_mutex_unlock(l)
+#endif
+
+static inline unsigned int align32pow2(unsigned int z)
+{
+    z -= 1;
+    z |= z >> 1;
+    z |= z >> 2;
+    z |= z >> 4;
+    z |= z >> 8;
+    z |= z >> 16;
+
+    return z + 1;
+}
+
+static xhash_lf_table_t* table_new(size_t bkt_size)
+{
+    xhash_lf_table_t* t = malloc(sizeof(xhash_lf_table_t)
+                                + sizeof(xhash_node_t*) * bkt_size);
+
+    if (t)
+    {
+        t->retired_next = NULL;
+        t->destroy      = 0;
+        t->bkt_size     = bkt_size;
+        t->buckets      = (xhash_node_t**)(t + 1);
+        memset(t->buckets, 0, sizeof(xhash_node_t*) * bkt_size);
+    }
+
+    return t;
+}
+
+static inline xhash_node_t* node_alloc(xhash_lf_t* xl)
+{
+    xhash_node_t* n = xl->cache;
+
+    if (n)
+    {
+        xl->cache = n->next;
+        return n;
+    }
+
+    return malloc(sizeof(xhash_node_t) + xl->data_size);
+}
+
+static inline void node_recycle(xhash_lf_t* xl, xhash_node_t* n)
+{
+    n->next = xl->cache;
+    xl->cache = n;
+}
+
+/* put all nodes of 't' into cache and free 't'. */
+static void table_release(xhash_lf_t* xl, xhash_lf_table_t* t)
+{
+    xhash_node_t* n;
+    xhash_node_t* next;
+    size_t i;
+
+    for (i = 0; i < t->bkt_size; ++i)
+    {
+        for (n = t->buckets[i]; n; n = next)
+        {
+            next = n->next;
+
+            if (t->destroy && xl->destroy_cb)
+                xl->destroy_cb(xhash_iter_data(n));
+            node_recycle(xl, n);
+        }
+    }
+
+    free(t);
+}
+
+/* reclaim the objects retired in epoch 'i' (mod 3). */
+static void epoch_reclaim(xhash_lf_t* xl, size_t i)
+{
+    xhash_node_t* n = xl->retired_nodes[i];
+    xhash_node_t* prev;
+    xhash_lf_table_t* t = xl->retired_tables[i];
+    xhash_lf_table_t* tnext;
+
+    while (n)
+    {
+        prev = n->prev;
+
+        if (xl->destroy_cb)
+            xl->destroy_cb(xhash_iter_data(n));
+        node_recycle(xl, n);
+
+        n = prev;
+    }
+
+    while (t)
+    {
+        tnext = t->retired_next;
+        table_release(xl, t);
+        t = tnext;
+    }
+
+    xl->retired_nodes[i] = NULL;
+    xl->retired_tables[i] = NULL;
+}
+
+/* advance global epoch from E to E+1 if all active readers are in E.
+ * then no reader can see the objects retired in E-1, reclaim them. */
+static int epoch_try_advance(xhash_lf_t* xl)
+{
+    size_t e = xl->epoch;
+    size_t s;
+    int i;
+
+    /* make the unlinking visible before checking readers */
+    fence_seq_cst();
+
+    for (i = 0; i < XHASH_LF_MAX_READERS; ++i)
+    {
+        s = (size_t)load_acquire(&xl->readers[i].state);
+
+        if ((s & 1) && (s >> 1) != e)
+            return -1;
+    }
+
+    store_release(&xl->epoch, e + 1);
+    epoch_reclaim(xl, (e + 2) % 3); /* (e - 1) % 3 */
+    return 0;
+}
+
+static inline void retire_node(xhash_lf_t* xl, xhash_node_t* n)
+{
+    /* 'next' is kept for the readers on 'n', 'prev' links the retired list */
+    n->prev = xl->retired_nodes[xl->epoch % 3];
+    xl->retired_nodes[xl->epoch % 3] = n;
+
+    if (++xl->retire_cnt >= XHASH_LF_RECLAIM_STEP)
+    {
+        xl->retire_cnt = 0;
+        epoch_try_advance(xl);
+    }
+}
+
+static inline void retire_table(xhash_lf_t* xl, xhash_lf_table_t* t)
+{
+    t->retired_next = xl->retired_tables[xl->epoch % 3];
+    xl->retired_tables[xl->epoch % 3] = t;
+
+    /* a table holds many nodes, don't wait */
+    xl->retire_cnt = 0;
+    epoch_try_advance(xl);
+}
+
+/* copy all nodes into a new table, the old table is never modified
+ * after the new one is published, so readers on it are safe. */
+static int table_expand(xhash_lf_t* xl)
+{
+    xhash_lf_table_t* t = xl->table;
+    xhash_lf_table_t* nt = table_new(t->bkt_size << 1);
+    xhash_node_t** bucket;
+    xhash_node_t* o;
+    xhash_node_t* n;
+    size_t i;
+
+    if (!nt) return -1;
+
+    for (i = 0; i < t->bkt_size; ++i)
+    {
+        for (o = t->buckets[i]; o; o = o->next)
+        {
+            n = node_alloc(xl);
+            if (!n)
+            {
+                table_release(xl, nt);
+                return -1;
+            }
+
+            memcpy(xhash_iter_data(n), xhash_iter_data(o), xl->data_size);
+            n->hash = o->hash;
+
+            bucket = &nt->buckets[n->hash & (nt->bkt_size - 1)];
+            n->prev = NULL;
+            n->next = *bucket;
+            if (n->next)
+                n->next->prev = n;
+            *bucket = n;
+        }
+    }
+
+    store_release(&xl->table, nt);
+    retire_table(xl, t);
+    return 0;
+}
+
+xhash_lf_t* xhash_lf_init(xhash_lf_t* xl, int size, size_t data_size,
+            xhash_hash_cb hash_cb, xhash_equal_cb equal_cb,
+            xhash_destroy_cb destroy_cb)
+{
+    xl->hash_cb     = hash_cb;
+    xl->equal_cb    = equal_cb;
+    xl->destroy_cb  = destroy_cb;
+    xl->data_size   = data_size;
+    xl->size        = 0;
+    xl->loadfactor  = XHASH_DEFAULT_LOADFACTOR;
+    xl->epoch       = 1;
+    xl->retire_cnt  = 0;
+    xl->cache       = NULL;
+
+    memset(xl->retired_nodes, 0, sizeof(xl->retired_nodes));
+    memset(xl->retired_tables, 0, sizeof(xl->retired_tables));
+
+    xl->readers = calloc(XHASH_LF_MAX_READERS, sizeof(xhash_lf_reader_t));
+    if (!xl->readers)
+        return NULL;
+
+    xl->table = table_new(size < XHASH_DEFAULT_SIZE
+                    ? XHASH_DEFAULT_SIZE : align32pow2(size));
+    if (!xl->table)
+    {
+        free(xl->readers);
+        return NULL;
+    }
+
+    lock_init(&xl->write_lock);
+    return xl;
+}
+
+void xhash_lf_destroy(xhash_lf_t* xl)
+{
+    xhash_node_t* n;
+    int i;
+
+    xl->table->destroy = 1;
+    table_release(xl, xl->table);
+
+    for (i = 0; i < 3; ++i)
+        epoch_reclaim(xl, i);
+
+    while ((n = xl->cache))
+    {
+        xl->cache = n->next;
+        free(n);
+    }
+
+    free(xl->readers);
+    lock_destroy(&xl->write_lock);
+}
+
+xhash_lf_t* xhash_lf_new(int size, size_t data_size, xhash_hash_cb hash_cb,
+            xhash_equal_cb equal_cb, xhash_destroy_cb destroy_cb)
+{
+    xhash_lf_t* xl = malloc(sizeof(xhash_lf_t));
+
+    if (xl)
+    {
+        if (xhash_lf_init(xl, size, data_size,
+                hash_cb, equal_cb, destroy_cb))
+            return xl;
+        free(xl);
+    }
+
+    return NULL;
+}
+
+void xhash_lf_free(xhash_lf_t* xl)
+{
+    if (xl)
+    {
+        xhash_lf_destroy(xl);
+        free(xl);
+    }
+}
+
+xhash_lf_reader_t* xhash_lf_register(xhash_lf_t* xl)
+{
+    int i, unused;
+
+    for (i = 0; i < XHASH_LF_MAX_READERS; ++i)
+    {
+        unused = 0;
+
+        if (cas_acquire(&xl->readers[i].used, unused, 1))
+            return &xl->readers[i];
+    }
+
+    return NULL;
+}
+
+void xhash_lf_unregister(xhash_lf_t* xl, xhash_lf_reader_t* r)
+{
+    store_release(&r->used, 0);
+}
+
+void xhash_lf_enter(xhash_lf_t* xl, xhash_lf_reader_t* r)
+{
+    store_relaxed(&r->state, ((size_t)load_relaxed(&xl->epoch) << 1) | 1);
+    /* announce the epoch before reading any pointer */
+    fence_seq_cst();
+}
+
+void xhash_lf_leave(xhash_lf_t* xl, xhash_lf_reader_t* r)
+{
+    store_release(&r->state, 0);
+}
+
+void* xhash_lf_find(xhash_lf_t* xl, const void* pdata)
+{
+    unsigned hash = xl->hash_cb((void*)pdata);
+    xhash_lf_table_t* t = load_acquire(&xl->table);
+    xhash_node_t* n = load_acquire(&t->buckets[hash & (t->bkt_size - 1)]);
+
+    while (n)
+    {
+        if (hash == n->hash
+            && xl->equal_cb(xhash_iter_data(n), (void*)pdata))
+        {
+            return xhash_iter_data(n);
+        }
+
+        n = load_acquire(&n->next);
+    }
+
+    return NULL;
+}
+
+int xhash_lf_get(xhash_lf_t* xl, xhash_lf_reader_t* r,
+            const void* pdata, void* out)
+{
+    void* p;
+
+    xhash_lf_enter(xl, r);
+
+    p = xhash_lf_find(xl, pdata);
+    if (p && out)
+        memcpy(out, p, xl->data_size);
+
+    xhash_lf_leave(xl, r);
+
+    return p != NULL;
+}
+
+int xhash_lf_put(xhash_lf_t* xl, const void* pdata)
+{
+    unsigned hash = xl->hash_cb((void*)pdata);
+    xhash_node_t** bucket;
+    xhash_node_t* n;
+
+    lock_acquire(&xl->write_lock);
+
+    bucket = &xl->table->buckets[hash & (xl->table->bkt_size - 1)];
+
+    for (n = *bucket; n; n = n->next)
+    {
+        if (hash == n->hash
+            && xl->equal_cb(xhash_iter_data(n), (void*)pdata))
+        {
+            lock_release(&xl->write_lock);
+            return 0;
+        }
+    }
+
+    n = node_alloc(xl);
+    if (!n)
+    {
+        lock_release(&xl->write_lock);
+        return -1;
+    }
+
+    /* fully initialize the node before publishing it */
+    memcpy(xhash_iter_data(n), pdata, xl->data_size);
+    n->hash = hash;
+    n->prev = NULL;
+    n->next = *bucket;
+    if (n->next)
+        n->next->prev = n;
+    store_release(bucket, n);
+
+    ++xl->size;
+
+    /* check loadfactor */
+    if (xl->size * 100 > xl->table->bkt_size * xl->loadfactor)
+        table_expand(xl);
+
+    lock_release(&xl->write_lock);
+    return 1;
+}
+
+int xhash_lf_remove(xhash_lf_t* xl, const void* pdata)
+{
+    unsigned hash = xl->hash_cb((void*)pdata);
+    xhash_node_t** bucket;
+    xhash_node_t* n;
+
+    lock_acquire(&xl->write_lock);
+
+    bucket = &xl->table->buckets[hash & (xl->table->bkt_size - 1)];
+
+    for (n = *bucket; n; n = n->next)
+    {
+        if (hash == n->hash
+            && xl->equal_cb(xhash_iter_data(n), (void*)pdata))
+            break;
+    }
+
+    if (n)
+    {
+        /* readers on 'n' can still go to 'n->next' */
+        if (n->prev)
+            store_release(&n->prev->next, n->next);
+        else
+            store_release(bucket, n->next);
+        if (n->next)
+            n->next->prev = n->prev;
+
+        --xl->size;
+        retire_node(xl, n);
+    }
+
+    lock_release(&xl->write_lock);
+    return n != NULL;
+}
+
+void xhash_lf_clear(xhash_lf_t* xl)
+{
+    xhash_lf_table_t* t;
+
+    lock_acquire(&xl->write_lock);
+
+    t = table_new(xl->table->bkt_size);
+    if (t)
+    {
+        xhash_lf_table_t* old = xl->table;
+
+        /* unpublish before retiring */
+        store_release(&xl->table, t);
+        old->destroy = 1;
+        retire_table(xl, old);
+        xl->size = 0;
+    }
+
+    lock_release(&xl->write_lock);
+}
+
+void xhash_lf_reclaim(xhash_lf_t* xl)
+{
+    lock_acquire(&xl->write_lock);
+    epoch_try_advance(xl);
+    lock_release(&xl->write_lock);
+}
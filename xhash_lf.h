@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#ifndef _XHASH_LF_H_
+#define _XHASH_LF_H_
+
+#include <stddef.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "xhash.h"
+
+/*
+ * hash table with lock-free read path, for read-mostly tables.
+ *
+ * readers never take a lock, they traverse bucket chains with acquire loads
+ * inside an epoch ('xhash_lf_enter'/'xhash_lf_leave'). writers are serialized
+ * by a mutex and publish with release stores. removed nodes (and old buckets
+ * after resizing) are retired, and go back to node cache only after every
+ * reader has left the epoch which could see them (epoch-based reclamation).
+ *
+ * resizing copies all nodes into a new table and publishes it at once,
+ * readers see either the old table or the new one, both are complete.
+ * element data MUST NOT be modified after insertion since readers may be
+ * reading it, remove and put it again instead.
+ */
+
+#ifndef XHASH_LF_MAX_READERS
+#define XHASH_LF_MAX_READERS    64  // max registered reader threads
+#endif
+
+#ifndef XHASH_LF_RECLAIM_STEP
+#define XHASH_LF_RECLAIM_STEP   64  // try to advance epoch every N retires
+#endif
+
+typedef struct xhash_lf         xhash_lf_t;
+typedef struct xhash_lf_table   xhash_lf_table_t;
+typedef struct xhash_lf_reader  xhash_lf_reader_t;
+
+#ifdef _WIN32
+typedef SRWLOCK                 xhash_lf_lock_t;
+#else
+typedef pthread_mutex_t         xhash_lf_lock_t;
+#endif
+
+struct xhash_lf_table
+{
+    xhash_lf_table_t*   retired_next;
+    int                 destroy;    // call 'destroy_cb' when reclaimed
+    size_t              bkt_size;
+    xhash_node_t**      buckets;
+};
+
+struct xhash_lf_reader
+{
+    size_t              state;      // (epoch << 1) | 1 when reading, 0 otherwise
+    int                 used;
+    char                pad[64 - sizeof(size_t) - sizeof(int)];
+};
+
+struct xhash_lf
+{
+    xhash_hash_cb       hash_cb;
+    xhash_equal_cb      equal_cb;
+    xhash_destroy_cb    destroy_cb;
+    size_t              data_size;
+    size_t              size;
+    size_t              loadfactor;
+    xhash_lf_table_t*   table;      // current table, read by readers
+    size_t              epoch;      // global epoch, only writer advances it
+    size_t              retire_cnt;
+    xhash_node_t*       retired_nodes[3];   // linked by 'prev', index 'epoch % 3'
+    xhash_lf_table_t*   retired_tables[3];
+    xhash_node_t*       cache;      // reclaimed nodes
+    xhash_lf_reader_t*  readers;
+    xhash_lf_lock_t     write_lock;
+};
+
+/* initialize a 'xhash_lf_t', arguments are the same as 'xhash_init'. */
+xhash_lf_t* xhash_lf_init(xhash_lf_t* xl, int size, size_t data_size,
+            xhash_hash_cb hash_cb, xhash_equal_cb equal_cb, xhash_destroy_cb destroy_cb);
+/* destroy a 'xhash_lf_t' which has called 'xhash_lf_init'.
+ * there MUST be no readers and writers. */
+void xhash_lf_destroy(xhash_lf_t* xl);
+
+/* allocate memory and initialize a 'xhash_lf_t'. */
+xhash_lf_t* xhash_lf_new(int size, size_t data_size, xhash_hash_cb hash_cb,
+            xhash_equal_cb equal_cb, xhash_destroy_cb destroy_cb);
+/* release memory for a 'xhash_lf_t' which 'xhash_lf_new' returns. */
+void xhash_lf_free(xhash_lf_t* xl);
+
+/* return the number of elements (writer side). */
+#define xhash_lf_size(xl)   ((xl)->size)
+
+/* register a reader thread, return 'NULL' if there are
+ * 'XHASH_LF_MAX_READERS' readers already. */
+xhash_lf_reader_t* xhash_lf_register(xhash_lf_t* xl);
+/* unregister a reader thread, it MUST not be in an epoch. */
+void xhash_lf_unregister(xhash_lf_t* xl, xhash_lf_reader_t* r);
+
+/* enter an epoch, the elements can be read until 'xhash_lf_leave'. */
+void xhash_lf_enter(xhash_lf_t* xl, xhash_lf_reader_t* r);
+/* leave the epoch. */
+void xhash_lf_leave(xhash_lf_t* xl, xhash_lf_reader_t* r);
+
+/* find an element with specific data, MUST be called between 'xhash_lf_enter'
+ * and 'xhash_lf_leave'. return a pointer to the element data which is valid
+ * until 'xhash_lf_leave', return 'NULL' if not found. */
+void* xhash_lf_find(xhash_lf_t* xl, const void* pdata);
+/* find an element with specific data and copy it into 'out' (can be 'NULL'),
+ * the epoch is entered and left inside. return 1 if found, 0 if not found. */
+int xhash_lf_get(xhash_lf_t* xl, xhash_lf_reader_t* r,
+            const void* pdata, void* out);
+
+/* insert an element with specific data (writer side). return 1 if inserted,
+ * 0 if the data is already exist (do nothing), -1 when out of memory. */
+int xhash_lf_put(xhash_lf_t* xl, const void* pdata);
+/* remove an element with specific data (writer side).
+ * return 1 if removed, 0 if not found. */
+int xhash_lf_remove(xhash_lf_t* xl, const void* pdata);
+/* remove all elements (writer side). */
+void xhash_lf_clear(xhash_lf_t* xl);
+/* try to reclaim retired nodes (writer side), it's done automatically
+ * every 'XHASH_LF_RECLAIM_STEP' retires, call it when writer is idle. */
+void xhash_lf_reclaim(xhash_lf_t* xl);
+
+#endif // _XHASH_LF_H_
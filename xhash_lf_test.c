@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "xhash_lf.h"
+#include "xhash_concurrent.h"
+
+#define RAND_SEED 123456
+
+typedef struct
+{
+    int key;
+    int value;
+} kv_t;
+
+unsigned kv_hash(void* pdata)
+{
+    return xhash_improve_hash((unsigned)((kv_t*)pdata)->key);
+}
+int kv_equal(void* l, void* r)
+{
+    return ((kv_t*)l)->key == ((kv_t*)r)->key;
+}
+
+void test()
+{
+    xhash_lf_t* xl = xhash_lf_new(-1, sizeof(kv_t), kv_hash, kv_equal, NULL);
+    xhash_lf_reader_t* r = xhash_lf_register(xl);
+    kv_t kv;
+    kv_t* p;
+    int i;
+
+    for (i = 0; i < 100; ++i)
+    {
+        kv.key = i;
+        kv.value = i * 10;
+        xhash_lf_put(xl, &kv);
+    }
+
+    kv.key = 42;
+    xhash_lf_remove(xl, &kv);
+
+    xhash_lf_enter(xl, r);
+    for (kv.key = 40; kv.key < 45; ++kv.key)
+    {
+        // 'p' is valid until 'xhash_lf_leave'
+        p = xhash_lf_find(xl, &kv);
+        if (p)
+            printf("key [%d] found, value %d\n", p->key, p->value);
+        else
+            printf("key [%d] not found\n", kv.key);
+    }
+    xhash_lf_leave(xl, r);
+
+    xhash_lf_unregister(xl, r);
+    xhash_lf_free(xl);
+}
+
+/* ------------------------------------- */
+typedef struct
+{
+    xhash_lf_t* xl;
+    xhash_concurrent_t* xc;
+    unsigned seed;
+    int nops;
+    int nkeys;
+    int found;
+} worker_t;
+
+static volatile int g_stop;
+
+// xorshift32, every thread has its own state
+static inline unsigned rand_next(unsigned* s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 17;
+    *s ^= *s << 5;
+    return *s;
+}
+void* reader(void* arg)
+{
+    worker_t* w = arg;
+    xhash_lf_reader_t* r = w->xl ? xhash_lf_register(w->xl) : NULL;
+    kv_t kv;
+    int i;
+
+    for (i = 0; i < w->nops; ++i)
+    {
+        kv.key = rand_next(&w->seed) % w->nkeys;
+
+        if (r ? xhash_lf_get(w->xl, r, &kv, NULL)
+              : xhash_concurrent_get(w->xc, &kv, NULL))
+            ++w->found;
+    }
+
+    if (r)
+        xhash_lf_unregister(w->xl, r);
+    return NULL;
+}
+// the single writer keeps updating keys beyond 'nkeys' until readers are done
+void* writer(void* arg)
+{
+    worker_t* w = arg;
+    kv_t kv;
+
+    while (!__atomic_load_n(&g_stop, __ATOMIC_RELAXED))
+    {
+        kv.key = w->nkeys + rand_next(&w->seed) % 1024;
+        kv.value = 0;
+
+        if (w->xl)
+        {
+            xhash_lf_put(w->xl, &kv);
+            xhash_lf_remove(w->xl, &kv);
+        }
+        else
+        {
+            xhash_concurrent_put(w->xc, &kv);
+            xhash_concurrent_remove(w->xc, &kv);
+        }
+    }
+
+    return NULL;
+}
+static double elapsed(struct timespec* b, struct timespec* e)
+{
+    return (e->tv_sec - b->tv_sec) + (e->tv_nsec - b->tv_nsec) / 1e9;
+}
+void test_speed(int lockfree, int nkeys, int nops)
+{
+    pthread_t threads[XHASH_LF_MAX_READERS];
+    worker_t workers[XHASH_LF_MAX_READERS];
+    pthread_t wthread;
+    worker_t wworker;
+    struct timespec begin, end;
+    xhash_lf_t* xl = NULL;
+    xhash_concurrent_t* xc = NULL;
+    kv_t kv;
+    int nthreads, i;
+
+    printf("[%s, %d keys, %d reads per thread, 1 writer]\n",
+        lockfree ? "xhash_lf_t" : "xhash_concurrent_t (1 shard)", nkeys, nops);
+
+    for (nthreads = 1; nthreads <= XHASH_LF_MAX_READERS / 2; nthreads <<= 1)
+    {
+        if (lockfree)
+            xl = xhash_lf_new(-1, sizeof(kv_t), kv_hash, kv_equal, NULL);
+        else
+            xc = xhash_concurrent_new(1, -1, sizeof(kv_t), kv_hash, kv_equal, NULL);
+
+        for (i = 0; i < nkeys; ++i)
+        {
+            kv.key = i;
+            kv.value = i;
+            if (lockfree)
+                xhash_lf_put(xl, &kv);
+            else
+                xhash_concurrent_put(xc, &kv);
+        }
+
+        g_stop = 0;
+        wworker.xl = xl;
+        wworker.xc = xc;
+        wworker.seed = RAND_SEED;
+        wworker.nkeys = nkeys;
+        pthread_create(&wthread, NULL, writer, &wworker);
+
+        timespec_get(&begin, TIME_UTC);
+        for (i = 0; i < nthreads; ++i)
+        {
+            workers[i].xl = xl;
+            workers[i].xc = xc;
+            workers[i].seed = RAND_SEED + i + 1;
+            workers[i].nops = nops;
+            workers[i].nkeys = nkeys;
+            workers[i].found = 0;
+            pthread_create(&threads[i], NULL, reader, &workers[i]);
+        }
+        for (i = 0; i < nthreads; ++i)
+            pthread_join(threads[i], NULL);
+        timespec_get(&end, TIME_UTC);
+
+        __atomic_store_n(&g_stop, 1, __ATOMIC_RELAXED);
+        pthread_join(wthread, NULL);
+
+        printf("readers %2d, time %lfs, %.2lf Mreads/s.\n", nthreads,
+            elapsed(&begin, &end), (double)nops * nthreads / elapsed(&begin, &end) / 1e6);
+
+        if (lockfree)
+            xhash_lf_free(xl);
+        else
+            xhash_concurrent_free(xc);
+    }
+}
+
+/* ------------------------------------- */
+
+int main(int argc, char** argv)
+{
+    // test();
+    test_speed(0, 1000000, 2000000);
+    test_speed(1, 1000000, 2000000);
+    return 0;
+}
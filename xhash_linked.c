@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#include <stdlib.h>
+
+#include "xhash_linked.h"
+
+#define iter_link(xl, iter) \
+            ((xhash_link_t*)((char*)xhash_iter_data(iter) + (xl)->link_off))
+#define link_iter(xl, link) \
+            xhash_data_iter((char*)(link) - (xl)->link_off)
+
+static inline void link_unlink(xhash_link_t* link)
+{
+    link->prev->next = link->next;
+    link->next->prev = link->prev;
+}
+
+/* link 'link' as the newest one. */
+static inline void link_append(xhash_linked_t* xl, xhash_link_t* link)
+{
+    link->prev = xl->head.prev;
+    link->next = &xl->head;
+    xl->head.prev->next = link;
+    xl->head.prev = link;
+}
+
+xhash_linked_t* xhash_linked_init(xhash_linked_t* xl, int size, size_t data_size,
+            size_t capacity, xhash_hash_cb hash_cb, xhash_equal_cb equal_cb,
+            xhash_destroy_cb destroy_cb)
+{
+    /* links follow the data, keep them aligned */
+    xl->data_size   = data_size;
+    xl->link_off    = (data_size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+    xl->capacity    = capacity;
+    xl->access_order= 0;
+    xl->evict_cb    = NULL;
+    xl->evict_ctx   = NULL;
+    xl->head.prev   = &xl->head;
+    xl->head.next   = &xl->head;
+
+    if (!xhash_init(&xl->xh, size, xl->link_off + sizeof(xhash_link_t),
+            hash_cb, equal_cb, destroy_cb))
+        return NULL;
+
+    return xl;
+}
+
+void xhash_linked_destroy(xhash_linked_t* xl)
+{
+    xhash_destroy(&xl->xh);
+}
+
+xhash_linked_t* xhash_linked_new(int size, size_t data_size, size_t capacity,
+            xhash_hash_cb hash_cb, xhash_equal_cb equal_cb, xhash_destroy_cb destroy_cb)
+{
+    xhash_linked_t* xl = malloc(sizeof(xhash_linked_t));
+
+    if (xl)
+    {
+        if (xhash_linked_init(xl, size, data_size, capacity,
+                hash_cb, equal_cb, destroy_cb))
+            return xl;
+        free(xl);
+    }
+
+    return NULL;
+}
+
+void xhash_linked_free(xhash_linked_t* xl)
+{
+    if (xl)
+    {
+        xhash_linked_destroy(xl);
+        free(xl);
+    }
+}
+
+xhash_iter_t xhash_linked_begin(xhash_linked_t* xl)
+{
+    return xl->head.next != &xl->head ? link_iter(xl, xl->head.next) : NULL;
+}
+
+xhash_iter_t xhash_linked_iter_next(xhash_linked_t* xl, xhash_iter_t iter)
+{
+    xhash_link_t* link = iter_link(xl, iter)->next;
+
+    return link != &xl->head ? link_iter(xl, link) : NULL;
+}
+
+xhash_iter_t xhash_linked_rbegin(xhash_linked_t* xl)
+{
+    return xl->head.prev != &xl->head ? link_iter(xl, xl->head.prev) : NULL;
+}
+
+xhash_iter_t xhash_linked_iter_prev(xhash_linked_t* xl, xhash_iter_t iter)
+{
+    xhash_link_t* link = iter_link(xl, iter)->prev;
+
+    return link != &xl->head ? link_iter(xl, link) : NULL;
+}
+
+xhash_iter_t xhash_linked_put_ex(xhash_linked_t* xl, const void* pdata, size_t ksz)
+{
+    size_t size = xhash_size(&xl->xh);
+    xhash_iter_t iter = xhash_put_ex(&xl->xh, pdata, ksz);
+    xhash_iter_t oldest;
+
+    if (!iter)
+        return NULL;
+
+    if (xhash_size(&xl->xh) == size)
+    {
+        /* already exist */
+        if (xl->access_order)
+            xhash_linked_touch(xl, iter);
+        return iter;
+    }
+
+    link_append(xl, iter_link(xl, iter));
+
+    if (xl->capacity && xhash_size(&xl->xh) > xl->capacity)
+    {
+        /* the new one is the newest, it's never evicted here */
+        oldest = link_iter(xl, xl->head.next);
+
+        if (xl->evict_cb)
+            xl->evict_cb(xhash_iter_data(oldest), xl->evict_ctx);
+        xhash_linked_remove(xl, oldest);
+    }
+
+    return iter;
+}
+
+xhash_iter_t xhash_linked_get(xhash_linked_t* xl, const void* pdata)
+{
+    xhash_iter_t iter = xhash_get(&xl->xh, pdata);
+
+    if (iter && xl->access_order)
+        xhash_linked_touch(xl, iter);
+
+    return iter;
+}
+
+void xhash_linked_touch(xhash_linked_t* xl, xhash_iter_t iter)
+{
+    xhash_link_t* link = iter_link(xl, iter);
+
+    if (link->next != &xl->head)
+    {
+        link_unlink(link);
+        link_append(xl, link);
+    }
+}
+
+void xhash_linked_remove(xhash_linked_t* xl, xhash_iter_t iter)
+{
+    link_unlink(iter_link(xl, iter));
+    xhash_remove(&xl->xh, iter);
+}
+
+int xhash_linked_pop_oldest(xhash_linked_t* xl)
+{
+    if (xl->head.next == &xl->head)
+        return 0;
+
+    xhash_linked_remove(xl, link_iter(xl, xl->head.next));
+    return 1;
+}
+
+void xhash_linked_clear(xhash_linked_t* xl)
+{
+    xhash_clear(&xl->xh);
+
+    xl->head.prev = &xl->head;
+    xl->head.next = &xl->head;
+}
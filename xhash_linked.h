@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#ifndef _XHASH_LINKED_H_
+#define _XHASH_LINKED_H_
+
+#include <stddef.h>
+
+#include "xhash.h"
+
+/*
+ * linked hash table, a 'xhash_t' whose elements are also linked in a
+ * doubly linked list, from the oldest to the newest. it keeps insertion
+ * order, or access order when 'xhash_linked_touch' is used (or access order
+ * mode is set), which makes a LRU cache with one allocation per element.
+ *
+ * the list links are stored behind the element data in the same node:
+ * +-------------+------------+------------------+
+ * | xhash_node  | data       | prev/next links  |
+ * +-------------+------------+------------------+
+ */
+
+typedef struct xhash_linked     xhash_linked_t;
+typedef struct xhash_link       xhash_link_t;
+
+/* called with the oldest element before it's evicted (and destroyed). */
+typedef void (*xhash_evict_cb)(void* pdata, void* ctx);
+
+struct xhash_link
+{
+    xhash_link_t*       prev;       // older
+    xhash_link_t*       next;       // newer
+};
+
+struct xhash_linked
+{
+    xhash_t             xh;
+    size_t              data_size;  // element data size without links
+    size_t              link_off;   // offset of links, 'data_size' aligned
+    size_t              capacity;   // 0 means unlimited
+    int                 access_order;
+    xhash_evict_cb      evict_cb;
+    void*               evict_ctx;
+    xhash_link_t        head;       // head.next is the oldest
+};
+
+/* initialize a 'xhash_linked_t'. 'capacity' is the max number of elements,
+ * the oldest one is evicted when it's exceeded, 0 means unlimited.
+ * other arguments are the same as 'xhash_init'. */
+xhash_linked_t* xhash_linked_init(xhash_linked_t* xl, int size, size_t data_size,
+            size_t capacity, xhash_hash_cb hash_cb, xhash_equal_cb equal_cb,
+            xhash_destroy_cb destroy_cb);
+/* destroy a 'xhash_linked_t' which has called 'xhash_linked_init'. */
+void xhash_linked_destroy(xhash_linked_t* xl);
+
+/* allocate memory and initialize a 'xhash_linked_t'. */
+xhash_linked_t* xhash_linked_new(int size, size_t data_size, size_t capacity,
+            xhash_hash_cb hash_cb, xhash_equal_cb equal_cb, xhash_destroy_cb destroy_cb);
+/* release memory for a 'xhash_linked_t' which 'xhash_linked_new' returns. */
+void xhash_linked_free(xhash_linked_t* xl);
+
+/* set the callback called before an element is evicted by capacity. */
+#define xhash_linked_set_evict(xl, cb, ctx) \
+                        ((xl)->evict_cb = (cb), (xl)->evict_ctx = (ctx))
+/* set access order mode, 'xhash_linked_get' touches the found element. */
+#define xhash_linked_set_access_order(xl, on) \
+                        (xl)->access_order = (on)
+
+/* return the number of elements. */
+#define xhash_linked_size(xl)   xhash_size(&(xl)->xh)
+/* check whether the container is empty. */
+#define xhash_linked_empty(xl)  xhash_empty(&(xl)->xh)
+/* return an iterator to the end. */
+#define xhash_linked_end(xl)    NULL
+
+/* return an iterator to the oldest element. */
+xhash_iter_t xhash_linked_begin(xhash_linked_t* xl);
+/* return the next (newer) iterator of 'iter'. */
+xhash_iter_t xhash_linked_iter_next(xhash_linked_t* xl, xhash_iter_t iter);
+/* return an iterator to the newest element. */
+xhash_iter_t xhash_linked_rbegin(xhash_linked_t* xl);
+/* return the previous (older) iterator of 'iter'. */
+xhash_iter_t xhash_linked_iter_prev(xhash_linked_t* xl, xhash_iter_t iter);
+
+/* insert an element with specific data as the newest one, return an iterator
+ * to the inserted element, return 'NULL' when out of memory. if the data is
+ * already exist, do nothing (touch it in access order mode) and return it's
+ * iterator. the oldest element is evicted if the capacity is exceeded. */
+#define xhash_linked_put(xl, pdata) \
+                        xhash_linked_put_ex(xl, pdata, (xl)->data_size)
+/* similar to 'xhash_linked_put', but just init the <key> (which size is 'ksz'). */
+xhash_iter_t xhash_linked_put_ex(xhash_linked_t* xl, const void* pdata, size_t ksz);
+/* find an element with specific data. return an iterator to
+ * the element with specific data, return 'NULL' if not found. */
+xhash_iter_t xhash_linked_get(xhash_linked_t* xl, const void* pdata);
+/* make 'iter' the newest element, 'iter' MUST be valid. */
+void xhash_linked_touch(xhash_linked_t* xl, xhash_iter_t iter);
+/* remove an element at 'iter', 'iter' MUST be valid. */
+void xhash_linked_remove(xhash_linked_t* xl, xhash_iter_t iter);
+/* remove the oldest element ('evict_cb' is not called).
+ * return 1 if removed, 0 if empty. */
+int xhash_linked_pop_oldest(xhash_linked_t* xl);
+/* remove all elements in 'xl'. */
+void xhash_linked_clear(xhash_linked_t* xl);
+
+#endif // _XHASH_LINKED_H_
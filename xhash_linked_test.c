@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "xhash_linked.h"
+#include "xlist.h"
+
+#define RAND_SEED 123456
+
+typedef struct
+{
+    int key;
+    int value;
+} kv_t;
+
+unsigned kv_hash(void* pdata)
+{
+    return xhash_improve_hash((unsigned)((kv_t*)pdata)->key);
+}
+int kv_equal(void* l, void* r)
+{
+    return ((kv_t*)l)->key == ((kv_t*)r)->key;
+}
+
+void on_evict(void* pdata, void* ctx)
+{
+    printf("evict key [%d]\n", ((kv_t*)pdata)->key);
+    ++*(int*)ctx;
+}
+
+void test()
+{
+    // a LRU cache which holds 4 elements at most
+    xhash_linked_t* xl = xhash_linked_new(-1, sizeof(kv_t), 4,
+                                kv_hash, kv_equal, NULL);
+    xhash_iter_t iter;
+    int evicted = 0;
+    kv_t kv;
+    int i;
+
+    xhash_linked_set_evict(xl, on_evict, &evicted);
+    xhash_linked_set_access_order(xl, 1);
+
+    for (i = 0; i < 4; ++i)
+    {
+        kv.key = i;
+        kv.value = i * 10;
+        xhash_linked_put(xl, &kv);
+    }
+
+    // key 0 becomes the newest, key 1 is evicted next
+    kv.key = 0;
+    xhash_linked_get(xl, &kv);
+
+    kv.key = 4;
+    kv.value = 40;
+    xhash_linked_put(xl, &kv);
+
+    // from the oldest to the newest: 2 3 0 4
+    for (iter = xhash_linked_begin(xl);
+            iter != xhash_linked_end(xl); iter = xhash_linked_iter_next(xl, iter))
+    {
+        printf("%d ", ((kv_t*)xhash_iter_data(iter))->key);
+    }
+    printf("\n");
+
+    xhash_linked_pop_oldest(xl);
+    printf("size %u, evicted %d\n", (unsigned)xhash_linked_size(xl), evicted);
+
+    xhash_linked_free(xl);
+}
+
+/* ------------------------------------- */
+// the LRU cache before 'xhash_linked_t': 'xhash_t' maps key to a 'xlist_t'
+// node, 2 allocations per element.
+typedef struct
+{
+    int key;
+    xlist_iter_t node; // the list node holds 'kv_t'
+} ref_t;
+
+static double elapsed(struct timespec* b, struct timespec* e)
+{
+    return (e->tv_sec - b->tv_sec) + (e->tv_nsec - b->tv_nsec) / 1e9;
+}
+// xorshift32
+static inline unsigned rand_next(unsigned* s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 17;
+    *s ^= *s << 5;
+    return *s;
+}
+// 'nops' random lookups in 'nkeys' keys, put when missed.
+void test_speed(int capacity, int nkeys, int nops)
+{
+    struct timespec begin, end;
+    xhash_linked_t* xl;
+    xhash_t* xh;
+    xlist_t* xls;
+    xhash_iter_t iter;
+    unsigned seed;
+    kv_t kv;
+    ref_t ref;
+    int hits, i;
+
+    // xhash_linked_t
+    xl = xhash_linked_new(capacity, sizeof(kv_t), capacity, kv_hash, kv_equal, NULL);
+    xhash_linked_set_access_order(xl, 1);
+
+    seed = RAND_SEED;
+    timespec_get(&begin, TIME_UTC);
+    for (hits = 0, i = 0; i < nops; ++i)
+    {
+        kv.key = rand_next(&seed) % nkeys;
+        kv.value = i;
+        if (xhash_linked_get(xl, &kv))
+            ++hits;
+        else
+            xhash_linked_put(xl, &kv);
+    }
+    timespec_get(&end, TIME_UTC);
+    printf("[xhash_linked_t] capacity %d, %d ops, time %lfs, hits %d, allocations %d.\n",
+        capacity, nops, elapsed(&begin, &end), hits, nops - hits);
+
+    xhash_linked_free(xl);
+
+    // xhash_t + xlist_t
+    xh = xhash_new(capacity, sizeof(ref_t), kv_hash, kv_equal, NULL);
+    xls = xlist_new(sizeof(kv_t), NULL);
+
+    seed = RAND_SEED;
+    timespec_get(&begin, TIME_UTC);
+    for (hits = 0, i = 0; i < nops; ++i)
+    {
+        kv.key = rand_next(&seed) % nkeys;
+        kv.value = i;
+        iter = xhash_get(xh, &kv);
+        if (iter)
+        {
+            // move to the back (newest), the node doesn't change
+            ref_t* r = xhash_iter_data(iter);
+            xlist_paste_back(xls, xlist_cut(xls, r->node));
+            ++hits;
+        }
+        else
+        {
+            if ((int)xlist_size(xls) == capacity)
+            {
+                // evict the front (oldest)
+                xhash_remove(xh, xhash_get(xh, xlist_front(xls)));
+                xlist_pop_front(xls);
+            }
+            ref.key = kv.key;
+            ref.node = xlist_push_back(xls, &kv);
+            xhash_put(xh, &ref);
+        }
+    }
+    timespec_get(&end, TIME_UTC);
+    printf("[xhash_t + xlist_t] capacity %d, %d ops, time %lfs, hits %d, allocations %d.\n",
+        capacity, nops, elapsed(&begin, &end), hits, (nops - hits) * 2);
+
+    xlist_free(xls);
+    xhash_free(xh);
+}
+
+/* ------------------------------------- */
+
+int main(int argc, char** argv)
+{
+    // test();
+    test_speed(1000000, 2000000, 10000000);
+    return 0;
+}
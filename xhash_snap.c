@@ -0,0 +1,355 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+/* 'fseeko' and 'ftello', 64-bit 'off_t' on 32-bit platforms */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+/* no 'mmap', the file is read into memory */
+/* 'long' is 32-bit on windows, 'fseek' and 'ftell' can't reach 2GB */
+typedef long long       file_off_t;
+#define file_seek(fp, off, whence)  _fseeki64(fp, off, whence)
+#define file_tell(fp)               _ftelli64(fp)
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+typedef off_t           file_off_t;
+#define file_seek(fp, off, whence)  fseeko(fp, off, whence)
+#define file_tell(fp)               ftello(fp)
+#endif
+
+#include "xhash_snap.h"
+
+#define ALIGN8(n)           (((n) + 7) & ~(size_t)7)
+/* offset of the data in a record, the hash code is before it */
+#define NODE_DATA_OFF       8
+/* bytes of records written at once */
+#define CHUNK_SIZE          (1 << 20)
+
+#define head_size()         ALIGN8(sizeof(xhash_snap_head_t))
+#define buckets_size(bkts)  ALIGN8(sizeof(unsigned) * ((bkts) + 1))
+
+/* write 'n' (< 8) zero bytes, return 0 on success. */
+static int write_pad(FILE* fp, size_t n)
+{
+    static const char zero[8] = { 0 };
+
+    return n && fwrite(zero, n, 1, fp) != 1 ? -1 : 0;
+}
+
+/* copy a record into 'chunk', write the chunk when it's full or 'last'. */
+static int write_record(FILE* fp, char* chunk, size_t* n, size_t chunk_nodes,
+            size_t node_size, xhash_t* xh, xhash_iter_t iter, int last)
+{
+    char* rec = chunk + node_size * *n;
+
+    *(unsigned*)rec = iter->hash;
+    memcpy(rec + NODE_DATA_OFF, xhash_iter_data(iter), xh->data_size);
+
+    if (++*n == chunk_nodes || last)
+    {
+        if (fwrite(chunk, node_size, *n, fp) != *n)
+            return -1;
+        *n = 0;
+    }
+
+    return 0;
+}
+
+#if XHASH_ENABLE_DENSE
+/* the iterating order is not the bucket order, group the nodes by bucket
+ * first: count, prefix sum, then place. */
+static int write_records(FILE* fp, xhash_t* xh, unsigned* buckets,
+            char* chunk, size_t chunk_nodes, size_t node_size)
+{
+    xhash_iter_t* nodes = malloc(sizeof(xhash_iter_t) * (xh->size ? xh->size : 1));
+    xhash_iter_t iter;
+    size_t mask = xh->bkt_size - 1;
+    size_t i, n = 0;
+    int ret = 0;
+
+    if (!nodes)
+        return -1;
+
+    for (iter = xhash_begin(xh); iter != xhash_end(xh);
+            iter = xhash_iter_next(xh, iter))
+        ++buckets[(iter->hash & mask) + 1];
+
+    for (i = 0; i < xh->bkt_size; ++i)
+        buckets[i + 1] += buckets[i];
+
+    for (iter = xhash_begin(xh); iter != xhash_end(xh);
+            iter = xhash_iter_next(xh, iter))
+        nodes[buckets[iter->hash & mask]++] = iter;
+
+    /* 'buckets[i]' is the end of bucket 'i' now, shift them back */
+    memmove(buckets + 1, buckets, sizeof(unsigned) * xh->bkt_size);
+    buckets[0] = 0;
+
+    for (i = 0; i < xh->size && ret == 0; ++i)
+        ret = write_record(fp, chunk, &n, chunk_nodes, node_size,
+                    xh, nodes[i], i + 1 == xh->size);
+
+    free(nodes);
+    return ret;
+}
+#else
+/* nodes are iterated bucket by bucket, write them in one pass. */
+static int write_records(FILE* fp, xhash_t* xh, unsigned* buckets,
+            char* chunk, size_t chunk_nodes, size_t node_size)
+{
+    xhash_iter_t iter;
+    xhash_iter_t next;
+    size_t mask = xh->bkt_size - 1;
+    size_t i, n = 0;
+
+    for (iter = xhash_begin(xh); iter != xhash_end(xh); iter = next)
+    {
+        next = xhash_iter_next(xh, iter);
+        ++buckets[(iter->hash & mask) + 1];
+
+        if (write_record(fp, chunk, &n, chunk_nodes, node_size,
+                xh, iter, next == xhash_end(xh)) != 0)
+            return -1;
+    }
+
+    for (i = 0; i < xh->bkt_size; ++i)
+        buckets[i + 1] += buckets[i];
+
+    return 0;
+}
+#endif
+
+int xhash_snap_save(xhash_t* xh, const char* path)
+{
+    xhash_snap_head_t head;
+    unsigned* buckets;
+    size_t node_size = NODE_DATA_OFF + ALIGN8(xh->data_size);
+    size_t chunk_nodes = CHUNK_SIZE / node_size + 1;
+    char* chunk;
+    FILE* fp;
+    int ret = -1;
+
+    /* indexes of records are 32 bits */
+    if (xh->size >= 0xffffffffU)
+        return -1;
+
+    buckets = calloc(xh->bkt_size + 1, sizeof(unsigned));
+    /* zeroed, the paddings stay zero */
+    chunk = calloc(chunk_nodes, node_size);
+
+    if (!buckets || !chunk)
+        goto out;
+
+    memset(&head, 0, sizeof(head));
+    memcpy(head.magic, XHASH_SNAP_MAGIC, sizeof(head.magic));
+    head.version    = XHASH_SNAP_VERSION;
+    head.node_size  = (unsigned)node_size;
+    head.data_size  = xh->data_size;
+    head.bkt_size   = xh->bkt_size;
+    head.size       = xh->size;
+    head.seed       = xh->seed;
+
+    fp = fopen(path, "wb");
+    if (!fp)
+        goto out;
+
+    /* records first, then the buckets are counted */
+    if (file_seek(fp, (file_off_t)(head_size() + buckets_size(xh->bkt_size)),
+                SEEK_SET) != 0
+        || write_records(fp, xh, buckets, chunk, chunk_nodes, node_size) != 0
+        || file_seek(fp, 0, SEEK_SET) != 0
+        || fwrite(&head, sizeof(head), 1, fp) != 1
+        || write_pad(fp, head_size() - sizeof(head))
+        || fwrite(buckets, sizeof(unsigned), xh->bkt_size + 1, fp)
+                != xh->bkt_size + 1
+        || write_pad(fp, buckets_size(xh->bkt_size)
+                - sizeof(unsigned) * (xh->bkt_size + 1)))
+        goto close;
+
+    ret = 0;
+
+close:
+    if (fclose(fp) != 0)
+        ret = -1;
+out:
+    free(buckets);
+    free(chunk);
+    return ret;
+}
+
+/* map the whole file read-only, return 'NULL' on failure. */
+static void* map_file(const char* path, size_t* length)
+{
+#ifdef _WIN32
+    FILE* fp = fopen(path, "rb");
+    void* base = NULL;
+    file_off_t len;
+
+    if (!fp)
+        return NULL;
+
+    /* a file larger than the address space can't be read in */
+    if (file_seek(fp, 0, SEEK_END) == 0 && (len = file_tell(fp)) > 0
+        && (unsigned long long)len <= (size_t)-1
+        && file_seek(fp, 0, SEEK_SET) == 0 && (base = malloc((size_t)len)) != NULL)
+    {
+        if (fread(base, (size_t)len, 1, fp) == 1)
+            *length = (size_t)len;
+        else
+        {
+            free(base);
+            base = NULL;
+        }
+    }
+
+    fclose(fp);
+    return base;
+#else
+    struct stat st;
+    void* base;
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+        return NULL;
+
+    if (fstat(fd, &st) != 0 || st.st_size <= 0
+        || (unsigned long long)st.st_size > (size_t)-1)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    /* pages are faulted in by lookups, nothing is read here */
+    base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (base == MAP_FAILED)
+        return NULL;
+
+    *length = st.st_size;
+    return base;
+#endif
+}
+
+static void unmap_file(void* base, size_t length)
+{
+#ifdef _WIN32
+    (void)length;
+    free(base);
+#else
+    munmap(base, length);
+#endif
+}
+
+xhash_snap_t* xhash_snap_open(xhash_snap_t* xs, const char* path,
+            xhash_hash_cb hash_cb, xhash_equal_cb equal_cb)
+{
+    const xhash_snap_head_t* head;
+    size_t length = 0;
+    void* base = map_file(path, &length);
+
+    if (!base)
+        return NULL;
+
+    head = base;
+
+    /* check the header only, the records are not touched */
+    if (length < head_size()
+        || memcmp(head->magic, XHASH_SNAP_MAGIC, sizeof(head->magic))
+        || head->version != XHASH_SNAP_VERSION
+        || head->node_size != NODE_DATA_OFF + ALIGN8(head->data_size)
+        || head->bkt_size == 0 || (head->bkt_size & (head->bkt_size - 1))
+        || head->bkt_size > length || head->size > length
+        || length != head_size() + buckets_size(head->bkt_size)
+                + head->node_size * head->size)
+    {
+        unmap_file(base, length);
+        return NULL;
+    }
+
+    xs->hash_cb     = hash_cb;
+    xs->seeded_hash_cb = NULL;
+    xs->equal_cb    = equal_cb;
+    xs->data_size   = (size_t)head->data_size;
+    xs->node_size   = head->node_size;
+    xs->bkt_size    = (size_t)head->bkt_size;
+    xs->size        = (size_t)head->size;
+    xs->seed        = head->seed;
+    xs->buckets     = (const unsigned*)((char*)base + head_size());
+    xs->nodes       = (const char*)xs->buckets + buckets_size(xs->bkt_size);
+    xs->base        = base;
+    xs->length      = length;
+
+    if (xs->buckets[xs->bkt_size] != xs->size)
+    {
+        unmap_file(base, length);
+        return NULL;
+    }
+
+    return xs;
+}
+
+void xhash_snap_close(xhash_snap_t* xs)
+{
+    unmap_file(xs->base, xs->length);
+}
+
+const void* xhash_snap_get(xhash_snap_t* xs, const void* pdata)
+{
+    unsigned hash = xs->seeded_hash_cb
+                ? xs->seeded_hash_cb((void*)pdata, xs->seed)
+                : xhash_seeded_hash(xs->hash_cb((void*)pdata), xs->seed);
+    size_t b = hash & (xs->bkt_size - 1);
+    size_t i = xs->buckets[b];
+    size_t end = xs->buckets[b + 1];
+    const char* rec;
+
+    /* a broken file can't make us read out of the records */
+    if (end > xs->size)
+        end = xs->size;
+
+    for (rec = xs->nodes + xs->node_size * i; i < end; ++i, rec += xs->node_size)
+    {
+        if (*(const unsigned*)rec == hash
+            && xs->equal_cb((void*)(rec + NODE_DATA_OFF), (void*)pdata))
+            return rec + NODE_DATA_OFF;
+    }
+
+    return NULL;
+}
+
+int xhash_snap_restore(xhash_snap_t* xs, xhash_t* xh)
+{
+    const char* rec = xs->nodes;
+    size_t i;
+
+    if (xh->data_size != xs->data_size)
+        return -1;
+
+    xh->seed = xs->seed;
+
+    if (xhash_reserve(xh, xs->size) != 0)
+        return -1;
+
+    for (i = 0; i < xs->size; ++i, rec += xs->node_size)
+    {
+        if (!xhash_put_hashed(xh, rec + NODE_DATA_OFF, *(const unsigned*)rec))
+            return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#ifndef _XHASH_SNAP_H_
+#define _XHASH_SNAP_H_
+
+#include <stddef.h>
+
+#include "xhash.h"
+
+/*
+ * snapshot of 'xhash_t', saved into a file without pointers and opened by
+ * 'mmap' (read-only), lookups are served from the mapping directly, nothing
+ * is rebuilt or rehashed. the stored hash codes are the seeded ones, the
+ * seed is saved together.
+ *
+ * file layout (native byte order, all offsets are 8 bytes aligned):
+ * +--------+-------------------------------+---------------------------+
+ * | header | buckets: 'bkt_size + 1' u32   | records: 'size' of them   |
+ * +--------+-------------------------------+---------------------------+
+ * the records of bucket 'i' are 'buckets[i]' ~ 'buckets[i + 1] - 1', every
+ * record is 'u32 hash, u32 pad, data', 'node_size' bytes.
+ *
+ * the data is copied byte by byte, so it MUST NOT contain pointers.
+ */
+
+#define XHASH_SNAP_MAGIC    "XHASHSNP"
+#define XHASH_SNAP_VERSION  1
+
+typedef struct xhash_snap       xhash_snap_t;
+typedef struct xhash_snap_head  xhash_snap_head_t;
+
+struct xhash_snap_head
+{
+    char                magic[8];
+    unsigned            version;
+    unsigned            node_size;  // bytes of a record
+    unsigned long long  data_size;
+    unsigned long long  bkt_size;
+    unsigned long long  size;
+    unsigned long long  seed;
+    unsigned long long  reserved[2];
+};
+
+struct xhash_snap
+{
+    xhash_hash_cb       hash_cb;
+    xhash_seeded_hash_cb seeded_hash_cb; // used instead of 'hash_cb' if not 'NULL'
+    xhash_equal_cb      equal_cb;
+    size_t              data_size;
+    size_t              node_size;
+    size_t              bkt_size;
+    size_t              size;
+    unsigned long long  seed;
+    const unsigned*     buckets;
+    const char*         nodes;
+    void*               base;       // the mapping (or memory) of the file
+    size_t              length;
+};
+
+/* save all elements of 'xh' into file 'path'.
+ * return 0 on success, -1 on failure (out of memory, io error). */
+int xhash_snap_save(xhash_t* xh, const char* path);
+
+/* open a snapshot file, 'hash_cb' and 'equal_cb' MUST be the ones of the
+ * saved 'xhash_t'. return 'xs' on success, 'NULL' if the file is not a valid
+ * snapshot or it can't be mapped. */
+xhash_snap_t* xhash_snap_open(xhash_snap_t* xs, const char* path,
+            xhash_hash_cb hash_cb, xhash_equal_cb equal_cb);
+/* set the seeded hash callback of 'xs', it MUST be the one of the saved
+ * 'xhash_t' if it has one (see 'xhash_set_seeded_hash'). */
+#define xhash_snap_set_seeded_hash(xs, cb) \
+                        (xs)->seeded_hash_cb = (cb)
+/* unmap a snapshot which 'xhash_snap_open' returns. */
+void xhash_snap_close(xhash_snap_t* xs);
+
+/* return the number of elements. */
+#define xhash_snap_size(xs)     ((xs)->size)
+/* return the data of the 'i'th element, 'i' MUST be less than the size. */
+#define xhash_snap_at(xs, i)    ((const void*)((xs)->nodes + (xs)->node_size * (i) + 8))
+
+/* find an element with specific data. return a pointer to the element
+ * (read-only, in the mapping), return 'NULL' if not found. */
+const void* xhash_snap_get(xhash_snap_t* xs, const void* pdata);
+
+/* insert all elements of 'xs' into 'xh' with the stored hash codes, 'xh'
+ * MUST be empty and has the same data size, it gets the seed of 'xs'. set
+ * multimap mode on 'xh' first if the saved one is a multimap.
+ * return 0 on success, -1 when out of memory. */
+int xhash_snap_restore(xhash_snap_t* xs, xhash_t* xh);
+
+#endif // _XHASH_SNAP_H_
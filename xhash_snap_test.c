@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "xhash_snap.h"
+
+#define RAND_SEED 123456
+#define SNAP_FILE "xhash_snap_test.snap"
+
+typedef struct
+{
+    unsigned long long key;
+    unsigned long long value;
+} kv_t;
+
+unsigned kv_hash(void* pdata)
+{
+    return (unsigned)xhash_int_hash64(((kv_t*)pdata)->key, 0);
+}
+int kv_equal(void* l, void* r)
+{
+    return ((kv_t*)l)->key == ((kv_t*)r)->key;
+}
+
+void test()
+{
+    xhash_t* xh = xhash_new(-1, sizeof(kv_t), kv_hash, kv_equal, NULL);
+    xhash_snap_t xs;
+    const kv_t* p;
+    kv_t kv;
+    int i;
+
+    for (i = 0; i < 10; ++i)
+    {
+        kv.key = i;
+        kv.value = i * 10;
+        xhash_put(xh, &kv);
+    }
+
+    xhash_snap_save(xh, SNAP_FILE);
+    xhash_free(xh);
+
+    if (!xhash_snap_open(&xs, SNAP_FILE, kv_hash, kv_equal))
+    {
+        printf("open snapshot failed\n");
+        return;
+    }
+
+    for (i = 0; i < 12; ++i)
+    {
+        kv.key = i;
+        p = xhash_snap_get(&xs, &kv);
+
+        if (p)
+            printf("%llu:%llu ", p->key, p->value);
+        else
+            printf("%d:- ", i);
+    }
+    printf("\nsize %u\n", (unsigned)xhash_snap_size(&xs));
+
+    xhash_snap_close(&xs);
+    remove(SNAP_FILE);
+}
+
+/* ------------------------------------- */
+
+static double elapsed(struct timespec* b, struct timespec* e)
+{
+    return (e->tv_sec - b->tv_sec) + (e->tv_nsec - b->tv_nsec) / 1e9;
+}
+// xorshift32
+static inline unsigned rand_next(unsigned* s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 17;
+    *s ^= *s << 5;
+    return *s;
+}
+static inline unsigned long long rand_u64(unsigned* s)
+{
+    unsigned long long h = rand_next(s);
+    return h << 32 | rand_next(s);
+}
+
+// startup time of a 'nvalues' table: rebuild it with 'xhash_put', open a
+// snapshot (then lookups fault the pages in), restore a snapshot into 'xhash_t'.
+void test_speed(int nvalues)
+{
+    struct timespec b, e;
+    xhash_t* xh;
+    xhash_snap_t xs;
+    unsigned seed;
+    int found, i;
+    kv_t kv;
+
+    /* rebuild */
+    seed = RAND_SEED;
+    timespec_get(&b, TIME_UTC);
+    xh = xhash_new(-1, sizeof(kv_t), kv_hash, kv_equal, NULL);
+    for (i = 0; i < nvalues; ++i)
+    {
+        kv.key = rand_u64(&seed);
+        kv.value = i;
+        xhash_put(xh, &kv);
+    }
+    timespec_get(&e, TIME_UTC);
+    printf("[rebuild] put %d, startup time %lfs.\n", nvalues, elapsed(&b, &e));
+
+    seed = RAND_SEED;
+    timespec_get(&b, TIME_UTC);
+    for (found = 0, i = 0; i < nvalues; ++i)
+    {
+        kv.key = rand_u64(&seed);
+        found += xhash_get(xh, &kv) != NULL;
+    }
+    timespec_get(&e, TIME_UTC);
+    printf("[rebuild] get %d, time %lfs, found %d.\n", nvalues, elapsed(&b, &e), found);
+
+    timespec_get(&b, TIME_UTC);
+    if (xhash_snap_save(xh, SNAP_FILE) != 0)
+    {
+        printf("save snapshot failed\n");
+        xhash_free(xh);
+        return;
+    }
+    timespec_get(&e, TIME_UTC);
+    printf("[snapshot] save %d, time %lfs.\n", nvalues, elapsed(&b, &e));
+
+    xhash_free(xh);
+
+    /* open the mapping */
+    timespec_get(&b, TIME_UTC);
+    if (!xhash_snap_open(&xs, SNAP_FILE, kv_hash, kv_equal))
+    {
+        printf("open snapshot failed\n");
+        return;
+    }
+    timespec_get(&e, TIME_UTC);
+    printf("[snapshot] open %d, startup time %lfs.\n", nvalues, elapsed(&b, &e));
+
+    seed = RAND_SEED;
+    timespec_get(&b, TIME_UTC);
+    for (found = 0, i = 0; i < nvalues; ++i)
+    {
+        kv.key = rand_u64(&seed);
+        found += xhash_snap_get(&xs, &kv) != NULL;
+    }
+    timespec_get(&e, TIME_UTC);
+    printf("[snapshot] get %d, time %lfs, found %d.\n", nvalues, elapsed(&b, &e), found);
+
+    /* restore into a mutable table, no rehashing */
+    timespec_get(&b, TIME_UTC);
+    xh = xhash_new(-1, sizeof(kv_t), kv_hash, kv_equal, NULL);
+    xhash_snap_restore(&xs, xh);
+    timespec_get(&e, TIME_UTC);
+    printf("[restore] put %u, startup time %lfs.\n",
+        (unsigned)xhash_size(xh), elapsed(&b, &e));
+
+    xhash_free(xh);
+    xhash_snap_close(&xs);
+    remove(SNAP_FILE);
+}
+
+/* ------------------------------------- */
+
+int main(int argc, char** argv)
+{
+    // test();
+    test_speed(20000000);
+    return 0;
+}
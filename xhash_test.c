@@ -8,6 +8,7 @@
 #include <string.h>
 #include <time.h>
 #include "xhash.h"
+#include "xlist.h"
 
 #define RAND_SEED 123456
 
@@ -27,28 +28,28 @@ int mystruct_equal(void* l, void* r)
     return strcmp(((mystruct_t*)l)->key, ((mystruct_t*)r)->key) == 0;
 }
 
-// dump the number of node in every bucket
+// dump the number of node in every bucket and the counters
 void xhash_dump(xhash_t* xh)
 {
-    int acc[100] = { 0 };
+    xhash_stats_t st;
     int i;
 
-    for (i = 0; i < xh->bkt_size; ++i)
-    {
-        int cnt = 0;
-        xhash_node_t* p = xh->buckets[i];
-        while (p)
-        {
-            p = p->next;
-            ++cnt;
-        }
-        ++acc[cnt];
-    }
-    for (i = 0; i < 100; ++i)
+    xhash_stats(xh, &st);
+
+    for (i = 0; i < XHASH_STATS_CHAINS; ++i)
     {
-        if (acc[i])
-            printf("the number of buckets which have %d nodes is %d.\n", i, acc[i]);
+        if (st.chains[i])
+            printf("the number of buckets which have %d%s nodes is %u.\n", i,
+                i == XHASH_STATS_CHAINS - 1 ? " or more" : "", (unsigned)st.chains[i]);
     }
+    printf("size %u, buckets %u, longest chain %u.\n",
+        (unsigned)st.size, (unsigned)st.bkt_size, (unsigned)st.max_chain);
+#if XHASH_ENABLE_STATS
+    printf("puts %llu, hits %llu, misses %llu, probes %.2lf (max %llu), "
+        "resizes %llu (%.3lfms), cache hits %llu.\n", st.puts, st.hits, st.misses,
+        st.hits + st.misses ? (double)st.probes / (st.hits + st.misses) : 0.0,
+        st.max_probe, st.resizes, st.resize_ns / 1e6, st.cache_hits);
+#endif
 }
 
 void test()
@@ -237,12 +238,621 @@ void test_ex()
     xhash_destroy(&xh);
 }
 
+/* ------------------------------------- */
+// move elements into another table without calling 'hash_cb' again
+void test_hashed()
+{
+    xhash_t* src = xhash_new(-1, sizeof(mystruct_t),
+                        mystruct_hash, mystruct_equal, NULL);
+    xhash_t* dst = xhash_new(-1, sizeof(mystruct_t),
+                        mystruct_hash, mystruct_equal, NULL);
+    mystruct_t myst;
+    xhash_iter_t iter;
+    unsigned hash;
+    int i;
+
+    // hash codes can be shared only between tables with the same seed
+    xhash_set_seed(dst, src->seed);
+
+    for (i = 0; i < 100; ++i)
+    {
+        sprintf(myst.key, "key-%d", i);
+        myst.value = i;
+        xhash_put(src, &myst);
+    }
+
+    for (iter = xhash_begin(src);
+            iter != xhash_end(src); iter = xhash_iter_next(src, iter))
+    {
+        xhash_put_hashed(dst, xhash_iter_data(iter), xhash_iter_hash(iter));
+    }
+
+    // hash once, probe twice
+    strcpy(myst.key, "key-42");
+    hash = xhash_hash_of(src, &myst);
+    if (xhash_get_hashed(src, &myst, hash) && xhash_get_hashed(dst, &myst, hash))
+        printf("key [%s] found in both tables, dst size %u\n",
+            myst.key, (unsigned)xhash_size(dst));
+
+    xhash_free(dst);
+    xhash_free(src);
+}
+
+/* ------------------------------------- */
+static unsigned long elapsed_ns(struct timespec* b, struct timespec* e)
+{
+    return (unsigned long)(e->tv_sec - b->tv_sec) * 1000000000UL
+            + e->tv_nsec - b->tv_nsec;
+}
+int ulong_cmp(const void* l, const void* r)
+{
+    return *(unsigned long*)l > *(unsigned long*)r ? 1 :
+                (*(unsigned long*)l < *(unsigned long*)r ? -1 : 0);
+}
+// latency of every single put, the spikes come from 'buckets_expand'
+void test_latency(int nvalues)
+{
+    xhash_t* xh = xhash_new(-1, sizeof(int), int_hash, int_equal, NULL);
+    unsigned long* lat = malloc(sizeof(unsigned long) * nvalues);
+    struct timespec begin, end;
+    int value, i;
+
+    srand(RAND_SEED);
+    for (i = 0; i < nvalues; ++i)
+    {
+        value = rand_int();
+        timespec_get(&begin, TIME_UTC);
+        xhash_put(xh, &value);
+        timespec_get(&end, TIME_UTC);
+        lat[i] = elapsed_ns(&begin, &end);
+    }
+
+    qsort(lat, nvalues, sizeof(unsigned long), ulong_cmp);
+    printf("put %d random integer (XHASH_ENABLE_INCREMENTAL=%d), latency "
+            "p50 %luns, p99 %luns, p999 %luns, max %luns.\n",
+            nvalues, XHASH_ENABLE_INCREMENTAL, lat[nvalues / 2],
+            lat[nvalues / 100 * 99], lat[nvalues / 1000 * 999], lat[nvalues - 1]);
+
+    free(lat);
+    xhash_free(xh);
+}
+
+/* ------------------------------------- */
+// search in random order, so that nodes are not visited in allocation order
+void test_batch(int nvalues, int batch)
+{
+    xhash_t* xh = xhash_new(-1, sizeof(int), int_hash, int_equal, NULL);
+    int* values = malloc(sizeof(int) * nvalues);
+    const void** keys = malloc(sizeof(void*) * nvalues);
+    xhash_iter_t* iters = malloc(sizeof(xhash_iter_t) * batch);
+    clock_t begin, end;
+    const void* key;
+    int count, i, j;
+
+    srand(RAND_SEED);
+    for (i = 0; i < nvalues; ++i)
+    {
+        values[i] = rand_int();
+        xhash_put(xh, &values[i]);
+    }
+    for (i = 0; i < nvalues; ++i)
+        keys[i] = &values[i];
+    for (i = nvalues - 1; i > 0; --i)
+    {
+        j = (unsigned)rand_int() % (i + 1);
+        key = keys[i];
+        keys[i] = keys[j];
+        keys[j] = key;
+    }
+
+    begin = clock();
+    for (count = 0, i = 0; i < nvalues; ++i)
+    {
+        if (xhash_get(xh, keys[i]))
+            ++count;
+    }
+    end = clock();
+    printf("xhash_get %d random integer done, time %lfs, found %d.\n",
+            nvalues, (double)(end - begin) / CLOCKS_PER_SEC, count);
+
+    begin = clock();
+    for (count = 0, i = 0; i < nvalues; i += batch)
+    {
+        int m = nvalues - i < batch ? nvalues - i : batch;
+
+        xhash_get_many(xh, keys + i, m, iters);
+        for (j = 0; j < m; ++j)
+        {
+            if (iters[j])
+                ++count;
+        }
+    }
+    end = clock();
+    printf("xhash_get_many (batch %d) %d random integer done, time %lfs, found %d.\n",
+            batch, nvalues, (double)(end - begin) / CLOCKS_PER_SEC, count);
+
+    free(iters);
+    free(keys);
+    free(values);
+    xhash_free(xh);
+}
+
+/* ------------------------------------- */
+// resident memory in KB, only available on linux
+static long rss_kb()
+{
+    FILE* fp = fopen("/proc/self/statm", "r");
+    long pages = 0;
+
+    if (fp)
+    {
+        if (fscanf(fp, "%*s %ld", &pages) != 1)
+            pages = 0;
+        fclose(fp);
+    }
+
+    return pages * 4; // assume 4KB page
+}
+// insert and remove all values for some rounds, then insert and clear.
+// shows how node allocation (XHASH_ENABLE_CACHE, XHASH_ENABLE_SLAB)
+// affects throughput and memory.
+void test_alloc(int nvalues, int rounds)
+{
+    // buckets are big enough, no expanding
+    xhash_t* xh = xhash_new(nvalues / 3 * 4, sizeof(int), int_hash, int_equal, NULL);
+    struct timespec begin, end;
+    unsigned long put_ns, remove_ns;
+    long rss_put;
+    int value, r, i;
+
+    printf("cache %d, slab %d, %d random integer.\n",
+        XHASH_ENABLE_CACHE, XHASH_ENABLE_SLAB, nvalues);
+
+    for (r = 0; r <= rounds; ++r)
+    {
+        srand(RAND_SEED + r);
+        timespec_get(&begin, TIME_UTC);
+        for (i = 0; i < nvalues; ++i)
+        {
+            value = rand_int();
+            xhash_put(xh, &value);
+        }
+        timespec_get(&end, TIME_UTC);
+        put_ns = elapsed_ns(&begin, &end);
+        rss_put = rss_kb();
+
+        timespec_get(&begin, TIME_UTC);
+        if (r < rounds)
+        {
+            srand(RAND_SEED + r);
+            for (i = 0; i < nvalues; ++i)
+            {
+                value = rand_int();
+                xhash_iter_t iter = xhash_get(xh, &value);
+                if (iter)
+                    xhash_remove(xh, iter);
+            }
+        }
+        else
+        {
+            xhash_clear(xh);
+        }
+        timespec_get(&end, TIME_UTC);
+        remove_ns = elapsed_ns(&begin, &end);
+
+        printf("round %d, put %.2lf Mops/s, rss %ldKB, %s %lfs, rss %ldKB.\n",
+            r, nvalues / (put_ns / 1e3), rss_put, r < rounds ? "remove" : "clear",
+            remove_ns / 1e9, rss_kb());
+    }
+
+    xhash_free(xh);
+}
+
+/* ------------------------------------- */
+static void sum_cb(void* pdata, void* ctx)
+{
+    *(long long*)ctx += *(int*)pdata;
+}
+// iterate a table which grew large and then shrank to 'nvalues / 100'
+void test_iterate(int nvalues, int rounds)
+{
+    xhash_t* xh = xhash_new(-1, sizeof(int), int_hash, int_equal, NULL);
+    struct timespec begin, end;
+    xhash_iter_t iter;
+    long long sum;
+    int value, r, i;
+
+    srand(RAND_SEED);
+    for (i = 0; i < nvalues; ++i)
+    {
+        value = rand_int();
+        xhash_put(xh, &value);
+    }
+
+    // walk 'xh' and remove 99% of elements, the buckets don't shrink
+    for (i = 0, iter = xhash_begin(xh); iter; ++i)
+    {
+        xhash_iter_t next = xhash_iter_next(xh, iter);
+        if (i % 100)
+            xhash_remove(xh, iter);
+        iter = next;
+    }
+
+    printf("dense %d, buckets %u, values %u.\n", XHASH_ENABLE_DENSE,
+        (unsigned)xh->bkt_size, (unsigned)xhash_size(xh));
+
+    timespec_get(&begin, TIME_UTC);
+    for (r = 0, sum = 0; r < rounds; ++r)
+    {
+        for (iter = xhash_begin(xh); iter; iter = xhash_iter_next(xh, iter))
+            sum += *(int*)xhash_iter_data(iter);
+    }
+    timespec_get(&end, TIME_UTC);
+    printf("xhash_iter_next %d rounds, time %lfs, sum %lld.\n",
+        rounds, elapsed_ns(&begin, &end) / 1e9, sum);
+
+    timespec_get(&begin, TIME_UTC);
+    for (r = 0, sum = 0; r < rounds; ++r)
+        xhash_foreach(xh, sum_cb, &sum);
+    timespec_get(&end, TIME_UTC);
+    printf("xhash_foreach %d rounds, time %lfs, sum %lld.\n",
+        rounds, elapsed_ns(&begin, &end) / 1e9, sum);
+
+    xhash_free(xh);
+}
+
+/* ------------------------------------- */
+// bulk load with or without 'xhash_reserve', then remove 99% of elements
+// and see how much memory 'xhash_shrink_to_fit' and lowfactor reclaim.
+// mode 0: default, 1: reserve, 2: lowfactor 10. run one mode per process,
+// the memory freed by previous mode may not be given back to system.
+void test_resize(int nvalues, int mode)
+{
+    xhash_t* xh = xhash_new(-1, sizeof(int), int_hash, int_equal, NULL);
+    struct timespec begin, end;
+    long rss = rss_kb();
+    int value, i;
+
+    if (mode == 2)
+        xhash_set_lowfactor(xh, 10);
+
+    srand(RAND_SEED);
+    timespec_get(&begin, TIME_UTC);
+    if (mode == 1)
+        xhash_reserve(xh, nvalues);
+    for (i = 0; i < nvalues; ++i)
+    {
+        value = rand_int();
+        xhash_put(xh, &value);
+    }
+    timespec_get(&end, TIME_UTC);
+    printf("%s: insert %d random integer, time %lfs, buckets %u, rss %ldKB.\n",
+        mode == 0 ? "default" : mode == 1 ? "reserve" : "lowfactor 10",
+        nvalues, elapsed_ns(&begin, &end) / 1e9, (unsigned)xh->bkt_size, rss_kb() - rss);
+
+    srand(RAND_SEED);
+    timespec_get(&begin, TIME_UTC);
+    for (i = 0; i < nvalues; ++i)
+    {
+        value = rand_int();
+        xhash_iter_t iter = xhash_get(xh, &value);
+        if (iter && i % 100)
+            xhash_remove(xh, iter);
+    }
+    timespec_get(&end, TIME_UTC);
+    printf("remove 99%%, time %lfs, buckets %u, rss %ldKB.\n",
+        elapsed_ns(&begin, &end) / 1e9, (unsigned)xh->bkt_size, rss_kb() - rss);
+
+    timespec_get(&begin, TIME_UTC);
+    xhash_shrink_to_fit(xh);
+    timespec_get(&end, TIME_UTC);
+    printf("shrink to fit, time %lfs, buckets %u, rss %ldKB.\n",
+        elapsed_ns(&begin, &end) / 1e9, (unsigned)xh->bkt_size, rss_kb() - rss);
+
+    xhash_free(xh);
+}
+
+/* ------------------------------------- */
+// throughput of hash functions by key length
+void test_hash_speed()
+{
+    static const int lens[] = { 4, 8, 16, 32, 64, 256, 1024, 4096 };
+    const size_t total = 256 << 20; // bytes hashed for every length
+    unsigned char* buf = malloc(4096 + 64);
+    struct timespec begin, end;
+    unsigned long long h;
+    size_t n, i, j;
+    int f;
+
+    for (i = 0; i < 4096 + 64; ++i)
+        buf[i] = (unsigned char)rand();
+
+    for (f = 0; f < 3; ++f)
+    {
+        printf("%s:", f == 0 ? "xhash_data_hash" : f == 1 ? "xhash_string_hash"
+                                                          : "xhash_hash64");
+        for (i = 0; i < sizeof(lens) / sizeof(lens[0]); ++i)
+        {
+            n = total / lens[i];
+            // NUL-terminated for 'xhash_string_hash'
+            buf[lens[i]] = 0;
+            for (j = 0; j < (size_t)lens[i]; ++j)
+                buf[j] |= 1;
+
+            h = 0;
+            timespec_get(&begin, TIME_UTC);
+            for (j = 0; j < n; ++j)
+            {
+                // vary the first byte, or the compiler may hoist the call
+                buf[0] = (unsigned char)(j | 1);
+                if (f == 0)
+                    h += xhash_data_hash(buf, lens[i]);
+                else if (f == 1)
+                    h += xhash_string_hash((const char*)buf);
+                else
+                    h += xhash_hash64(buf, lens[i], RAND_SEED);
+            }
+            timespec_get(&end, TIME_UTC);
+            printf(" %dB %.2lfGB/s%s", lens[i], total / (elapsed_ns(&begin, &end) / 1e9)
+                / (1 << 30), h == 1 ? "!" : ""); // use 'h'
+        }
+        printf("\n");
+    }
+
+    free(buf);
+}
+
+/* ------------------------------------- */
+// multimap, 'nkeys' keys with 1 ~ 'maxvals' values each. compared with
+// 'xhash_t' + a 'xlist_t' of values per key ('multi' is 0), run one mode
+// per process, the first one pays for page faults.
+typedef struct
+{
+    int key;
+    int value;
+} mkv_t;
+typedef struct
+{
+    int key;
+    xlist_t* values;
+} kl_t;
+
+void test_multi(int nkeys, int maxvals, int multi)
+{
+    const char* name = multi ? "multimap" : "xhash_t + xlist_t";
+    int* keys = malloc(sizeof(int) * nkeys);
+    struct timespec begin, end;
+    xhash_iter_t iter, last;
+    xlist_iter_t liter;
+    xhash_t* xh;
+    mkv_t mkv;
+    kl_t kl;
+    long long sum;
+    int count, i, j;
+
+    // distinct keys in random order (multiplying by an odd number is a bijection)
+    for (i = 0; i < nkeys; ++i)
+        keys[i] = (int)(i * 2654435761u);
+
+    if (multi)
+    {
+        xh = xhash_new(-1, sizeof(mkv_t), int_hash, int_equal, NULL);
+        xhash_set_multi(xh, 1);
+    }
+    else
+    {
+        xh = xhash_new(-1, sizeof(kl_t), int_hash, int_equal, NULL);
+    }
+
+    srand(RAND_SEED);
+    timespec_get(&begin, TIME_UTC);
+    for (count = 0, i = 0; i < nkeys; ++i)
+    {
+        j = rand() % maxvals + 1;
+        count += j;
+
+        if (multi)
+        {
+            for (mkv.key = keys[i]; j > 0; --j)
+            {
+                mkv.value = j;
+                xhash_put(xh, &mkv);
+            }
+        }
+        else
+        {
+            kl.key = keys[i];
+            kl.values = xlist_new(sizeof(int), NULL);
+            xhash_put(xh, &kl);
+            for (; j > 0; --j)
+                xlist_push_back(kl.values, &j);
+        }
+    }
+    timespec_get(&end, TIME_UTC);
+    printf("[%s] put %d keys %d values, time %lfs.\n",
+        name, nkeys, count, elapsed_ns(&begin, &end) / 1e9);
+
+    timespec_get(&begin, TIME_UTC);
+    for (sum = 0, i = 0; i < nkeys; ++i)
+    {
+        if (multi)
+        {
+            mkv.key = keys[i];
+            for (iter = xhash_equal_range(xh, &mkv, &last);
+                    iter != last; iter = xhash_range_next(iter))
+                sum += ((mkv_t*)xhash_iter_data(iter))->value;
+        }
+        else
+        {
+            kl.key = keys[i];
+            kl.values = ((kl_t*)xhash_get_data(xh, &kl))->values;
+            for (liter = xlist_begin(kl.values);
+                    liter != xlist_end(kl.values); liter = xlist_iter_next(liter))
+                sum += *(int*)xlist_iter_value(liter);
+        }
+    }
+    timespec_get(&end, TIME_UTC);
+    printf("[%s] get %d keys, time %lfs, sum %lld.\n",
+        name, nkeys, elapsed_ns(&begin, &end) / 1e9, sum);
+
+    timespec_get(&begin, TIME_UTC);
+    for (count = 0, i = 0; i < nkeys; ++i)
+    {
+        if (multi)
+        {
+            mkv.key = keys[i];
+            count += (int)xhash_remove_all(xh, &mkv);
+        }
+        else
+        {
+            kl.key = keys[i];
+            iter = xhash_get(xh, &kl);
+            kl.values = ((kl_t*)xhash_iter_data(iter))->values;
+            count += (int)xlist_size(kl.values);
+            xlist_free(kl.values);
+            xhash_remove(xh, iter);
+        }
+    }
+    timespec_get(&end, TIME_UTC);
+    printf("[%s] remove %d keys %d values, time %lfs.\n",
+        name, nkeys, count, elapsed_ns(&begin, &end) / 1e9);
+
+    xhash_free(xh);
+    free(keys);
+}
+
+/* ------------------------------------- */
+// load 'nvalues' records with 'xhash_put' one by one ('nthreads' == 0)
+// or 'xhash_build' by 'nthreads' threads, then get them all.
+// run one mode per process.
+void test_build(int nvalues, int nthreads)
+{
+    mkv_t* records = malloc(sizeof(mkv_t) * nvalues);
+    xhash_t* xh = xhash_new(-1, sizeof(mkv_t), int_hash, int_equal, NULL);
+    struct timespec begin, end;
+    int found, i;
+
+    // distinct keys in random order
+    for (i = 0; i < nvalues; ++i)
+    {
+        records[i].key = (int)(i * 2654435761u);
+        records[i].value = i;
+    }
+
+    timespec_get(&begin, TIME_UTC);
+    if (nthreads == 0)
+    {
+        for (i = 0; i < nvalues; ++i)
+            xhash_put(xh, &records[i]);
+    }
+    else
+    {
+        xhash_build(xh, records, nvalues, nthreads);
+    }
+    timespec_get(&end, TIME_UTC);
+
+    if (nthreads == 0)
+        printf("[xhash_put] load %d, time %lfs.\n",
+            nvalues, elapsed_ns(&begin, &end) / 1e9);
+    else
+        printf("[xhash_build %d threads] load %d, time %lfs.\n",
+            nthreads, nvalues, elapsed_ns(&begin, &end) / 1e9);
+
+    timespec_get(&begin, TIME_UTC);
+    for (found = 0, i = 0; i < nvalues; ++i)
+        found += xhash_get(xh, &records[i]) != NULL;
+    timespec_get(&end, TIME_UTC);
+    printf("get %d, time %lfs, found %d, size %u.\n", nvalues,
+        elapsed_ns(&begin, &end) / 1e9, found, (unsigned)xhash_size(xh));
+
+    xhash_free(xh);
+    free(records);
+}
+
+/* ------------------------------------- */
+// 'nvalues' elements, then get 'nvalues' keys of which 1 in 'hit' is present,
+// without and with the prefilter ('bits' per element) on the same table,
+// 3 rounds of each. it needs 'XHASH_ENABLE_BLOOM'.
+#if XHASH_ENABLE_BLOOM
+void test_bloom(int nvalues, int hit, unsigned bits)
+{
+    xhash_t* xh = xhash_new(-1, sizeof(int), int_hash, int_equal, NULL);
+    struct timespec begin, end;
+    int found, key, i, pass;
+
+    // present keys are multiples of 'hit'
+    for (i = 0; i < nvalues; ++i)
+    {
+        key = (int)((unsigned)i * hit * 2654435761u);
+        xhash_put(xh, &key);
+    }
+
+    for (pass = 0; pass < 6; ++pass)
+    {
+        if (xhash_set_bloom(xh, pass & 1 ? bits : 0) != 0)
+            break;
+
+        timespec_get(&begin, TIME_UTC);
+        for (found = 0, i = 0; i < nvalues; ++i)
+        {
+            key = (int)((unsigned)i * 2654435761u);
+            found += xhash_get(xh, &key) != NULL;
+        }
+        timespec_get(&end, TIME_UTC);
+
+        printf("[%s] get %d, found %d, time %lfs, %.2lf Mops/s, filter %uKB.\n",
+            pass & 1 ? "bloom" : "no filter", nvalues, found, elapsed_ns(&begin, &end) / 1e9,
+            nvalues / (elapsed_ns(&begin, &end) / 1e9) / 1e6,
+            (unsigned)(xh->bloom.blocks ? xbloom_memory(&xh->bloom) >> 10 : 0));
+    }
+
+    xhash_free(xh);
+}
+#endif
+
+// detect a bad hash function: keys are multiples of 'stride', 'int_hash'
+// (identity) puts them into 1 / 'stride' of the buckets when 'stride' is 2^n.
+void test_stats(int nvalues, int stride)
+{
+    xhash_t* xh = xhash_new(-1, sizeof(int), int_hash, int_equal, NULL);
+    int found, key, i;
+
+    for (i = 0; i < nvalues; ++i)
+    {
+        key = i * stride;
+        xhash_put(xh, &key);
+    }
+
+    for (found = 0, i = 0; i < nvalues * 2; ++i)
+    {
+        key = i * stride; // the second half are misses
+        found += xhash_get(xh, &key) != NULL;
+    }
+
+    printf("[stride %d] put %d, get %d, found %d.\n", stride, nvalues, nvalues * 2, found);
+    xhash_dump(xh);
+
+    xhash_free(xh);
+}
+
 /* ------------------------------------- */
 
 int main(int argc, char** argv)
 {
     // test();
     // test_ex();
+    // test_hashed();
+    // test_latency(5000000);
+    // test_batch(5000000, 64);
+    // test_alloc(5000000, 3);
+    // test_iterate(5000000, 20);
+    // test_resize(5000000, 0);
+    // test_hash_speed();
+    // test_multi(1000000, 8, 1);
+    // test_build(20000000, 4);
+    // test_bloom(10000000, 10, 10);
+    // test_stats(100000, 1);
+    // test_stats(100000, 1024);
     test_speed(5000000);
     return 0;
 }
\ No newline at end of file
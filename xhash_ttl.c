@@ -0,0 +1,314 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#include <stdlib.h>
+
+#include "xhash_ttl.h"
+
+#define WHEEL_MASK          (XHASH_TTL_WHEEL_SLOTS - 1)
+/* the max delta the wheel can hold, larger ones are re-queued */
+#define WHEEL_SPAN          ((1ULL << (XHASH_TTL_WHEEL_BITS * XHASH_TTL_WHEEL_LEVELS)) - 1)
+
+#define wheel_slot(xt, level, idx) \
+            (&(xt)->wheel[(level) * XHASH_TTL_WHEEL_SLOTS + (idx)])
+#define iter_meta(xt, iter) \
+            ((xhash_ttl_meta_t*)((char*)xhash_iter_data(iter) + (xt)->meta_off))
+#define meta_iter(xt, meta) \
+            xhash_data_iter((char*)(meta) - (xt)->meta_off)
+
+static inline void link_init(xhash_ttl_link_t* link)
+{
+    link->prev = link;
+    link->next = link;
+}
+
+static inline void link_unlink(xhash_ttl_link_t* link)
+{
+    link->prev->next = link->next;
+    link->next->prev = link->prev;
+}
+
+static inline void link_append(xhash_ttl_link_t* head, xhash_ttl_link_t* link)
+{
+    link->prev = head->prev;
+    link->next = head;
+    head->prev->next = link;
+    head->prev = link;
+}
+
+/* link 'meta' into the slot which is processed at tick 'meta->expire', the
+ * level is the lowest one whose range covers the distance from 'clock'.
+ * the ticks before 'clock' have been processed, already expired ones are
+ * linked into 'due'. */
+static void wheel_add(xhash_ttl_t* xt, xhash_ttl_meta_t* meta)
+{
+    unsigned long long expire = meta->expire;
+    unsigned long long delta;
+    unsigned level = 0;
+
+    if (expire < xt->clock)
+    {
+        meta->level = XHASH_TTL_WHEEL_LEVELS;
+        ++xt->counts[XHASH_TTL_WHEEL_LEVELS];
+        link_append(&xt->due, &meta->link);
+        return;
+    }
+
+    if (expire - xt->clock > WHEEL_SPAN)
+        expire = xt->clock + WHEEL_SPAN;
+
+    delta = expire - xt->clock;
+
+    while (delta >> (XHASH_TTL_WHEEL_BITS * (level + 1)))
+        ++level;
+
+    meta->level = level;
+    ++xt->counts[level];
+
+    link_append(wheel_slot(xt, level,
+        (expire >> (XHASH_TTL_WHEEL_BITS * level)) & WHEEL_MASK), &meta->link);
+}
+
+static inline void wheel_del(xhash_ttl_t* xt, xhash_ttl_meta_t* meta)
+{
+    link_unlink(&meta->link);
+    --xt->counts[meta->level];
+}
+
+static inline void link_splice(xhash_ttl_link_t* head, xhash_ttl_link_t* list)
+{
+    if (list->next != list)
+    {
+        list->next->prev = head->prev;
+        list->prev->next = head;
+        head->prev->next = list->next;
+        head->prev = list->prev;
+        link_init(list);
+    }
+}
+
+/* the slots which start at 'clock' are moved to 'pending' (in O(1)), their
+ * elements are re-queued to lower levels by 'xhash_ttl_expire' later, they
+ * keep the old 'level' until then. */
+static void wheel_cascade(xhash_ttl_t* xt)
+{
+    unsigned level;
+
+    for (level = 1; level < XHASH_TTL_WHEEL_LEVELS; ++level)
+    {
+        if (xt->clock & ((1ULL << (XHASH_TTL_WHEEL_BITS * level)) - 1))
+            break;
+
+        link_splice(&xt->pending, wheel_slot(xt, level,
+            (xt->clock >> (XHASH_TTL_WHEEL_BITS * level)) & WHEEL_MASK));
+    }
+}
+
+/* move 'clock' forward (at most to 'now + 1'), skip the ticks which
+ * have nothing to do. */
+static void wheel_advance(xhash_ttl_t* xt, unsigned long long now)
+{
+    unsigned long long next;
+    unsigned level = 0;
+
+    /* levels below 'level' are all empty */
+    while (level < XHASH_TTL_WHEEL_LEVELS && !xt->counts[level])
+        ++level;
+
+    if (level == XHASH_TTL_WHEEL_LEVELS)
+        next = now + 1;
+    else
+    {
+        next = (xt->clock | ((1ULL << (XHASH_TTL_WHEEL_BITS * level)) - 1)) + 1;
+        if (next > now + 1)
+            next = now + 1;
+    }
+
+    xt->clock = next;
+    wheel_cascade(xt);
+}
+
+static void wheel_reset(xhash_ttl_t* xt)
+{
+    int i;
+
+    for (i = 0; i < XHASH_TTL_WHEEL_SLOTS * XHASH_TTL_WHEEL_LEVELS; ++i)
+        link_init(&xt->wheel[i]);
+    for (i = 0; i <= XHASH_TTL_WHEEL_LEVELS; ++i)
+        xt->counts[i] = 0;
+
+    link_init(&xt->due);
+    link_init(&xt->pending);
+}
+
+/* call 'expire_cb' and remove the element of 'link'. */
+static inline void expire_link(xhash_ttl_t* xt, xhash_ttl_link_t* link)
+{
+    xhash_iter_t iter = meta_iter(xt, link);
+
+    if (xt->expire_cb)
+        xt->expire_cb(xhash_iter_data(iter), xt->expire_ctx);
+    xhash_ttl_remove(xt, iter);
+}
+
+xhash_ttl_t* xhash_ttl_init(xhash_ttl_t* xt, int size, size_t data_size,
+            unsigned long long now, xhash_hash_cb hash_cb, xhash_equal_cb equal_cb,
+            xhash_destroy_cb destroy_cb)
+{
+    /* meta follows the data, keep it aligned */
+    xt->data_size   = data_size;
+    xt->meta_off    = (data_size + 7) & ~(size_t)7;
+    xt->clock       = now;
+    xt->expire_cb   = NULL;
+    xt->expire_ctx  = NULL;
+    xt->wheel       = malloc(sizeof(xhash_ttl_link_t)
+                        * XHASH_TTL_WHEEL_SLOTS * XHASH_TTL_WHEEL_LEVELS);
+
+    if (!xt->wheel)
+        return NULL;
+
+    wheel_reset(xt);
+
+    if (!xhash_init(&xt->xh, size, xt->meta_off + sizeof(xhash_ttl_meta_t),
+            hash_cb, equal_cb, destroy_cb))
+    {
+        free(xt->wheel);
+        return NULL;
+    }
+
+    return xt;
+}
+
+void xhash_ttl_destroy(xhash_ttl_t* xt)
+{
+    xhash_destroy(&xt->xh);
+    free(xt->wheel);
+}
+
+xhash_ttl_t* xhash_ttl_new(int size, size_t data_size, unsigned long long now,
+            xhash_hash_cb hash_cb, xhash_equal_cb equal_cb, xhash_destroy_cb destroy_cb)
+{
+    xhash_ttl_t* xt = malloc(sizeof(xhash_ttl_t));
+
+    if (xt)
+    {
+        if (xhash_ttl_init(xt, size, data_size, now,
+                hash_cb, equal_cb, destroy_cb))
+            return xt;
+        free(xt);
+    }
+
+    return NULL;
+}
+
+void xhash_ttl_free(xhash_ttl_t* xt)
+{
+    if (xt)
+    {
+        xhash_ttl_destroy(xt);
+        free(xt);
+    }
+}
+
+xhash_iter_t xhash_ttl_put_ex(xhash_ttl_t* xt, const void* pdata,
+            size_t ksz, unsigned long long expire)
+{
+    size_t size = xhash_size(&xt->xh);
+    xhash_iter_t iter = xhash_put_ex(&xt->xh, pdata, ksz);
+    xhash_ttl_meta_t* meta;
+
+    if (!iter)
+        return NULL;
+
+    meta = iter_meta(xt, iter);
+
+    /* already exist, re-queue it */
+    if (xhash_size(&xt->xh) == size)
+        wheel_del(xt, meta);
+
+    meta->expire = expire;
+    wheel_add(xt, meta);
+
+    return iter;
+}
+
+xhash_iter_t xhash_ttl_get(xhash_ttl_t* xt, const void* pdata, unsigned long long now)
+{
+    xhash_iter_t iter = xhash_get(&xt->xh, pdata);
+
+    if (iter && iter_meta(xt, iter)->expire <= now)
+    {
+        expire_link(xt, &iter_meta(xt, iter)->link);
+        return NULL;
+    }
+
+    return iter;
+}
+
+void xhash_ttl_set_expire(xhash_ttl_t* xt, xhash_iter_t iter, unsigned long long expire)
+{
+    xhash_ttl_meta_t* meta = iter_meta(xt, iter);
+
+    wheel_del(xt, meta);
+    meta->expire = expire;
+    wheel_add(xt, meta);
+}
+
+void xhash_ttl_remove(xhash_ttl_t* xt, xhash_iter_t iter)
+{
+    wheel_del(xt, iter_meta(xt, iter));
+    xhash_remove(&xt->xh, iter);
+}
+
+size_t xhash_ttl_expire(xhash_ttl_t* xt, unsigned long long now, size_t budget)
+{
+    xhash_ttl_meta_t* meta;
+    xhash_ttl_link_t* slot;
+    size_t count = 0;
+
+    for (; budget; --budget)
+    {
+        if (xt->due.next != &xt->due)
+        {
+            expire_link(xt, xt->due.next);
+            ++count;
+            continue;
+        }
+
+        /* finish cascading before the ticks from 'clock' */
+        if (xt->pending.next != &xt->pending)
+        {
+            meta = (xhash_ttl_meta_t*)xt->pending.next;
+            wheel_del(xt, meta);
+            wheel_add(xt, meta);
+            continue;
+        }
+
+        if (xt->clock > now)
+            break;
+
+        slot = wheel_slot(xt, 0, xt->clock & WHEEL_MASK);
+
+        if (slot->next == slot)
+        {
+            /* advancing is not charged, it's bounded by the levels */
+            wheel_advance(xt, now);
+            ++budget;
+            continue;
+        }
+
+        /* every element in this slot has expired at 'clock' */
+        expire_link(xt, slot->next);
+        ++count;
+    }
+
+    return count;
+}
+
+void xhash_ttl_clear(xhash_ttl_t* xt)
+{
+    xhash_clear(&xt->xh);
+    wheel_reset(xt);
+}
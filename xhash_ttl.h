@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#ifndef _XHASH_TTL_H_
+#define _XHASH_TTL_H_
+
+#include <stddef.h>
+
+#include "xhash.h"
+
+/*
+ * expiring hash table, every element has an expire time. elements are linked
+ * into a hierarchical timing wheel (like linux kernel timers), so expiring
+ * costs O(expired elements) instead of scanning the whole table. an element
+ * is moved to a lower level at most 'XHASH_TTL_WHEEL_LEVELS - 1' times.
+ *
+ * time is in ticks defined by caller (e.g. milliseconds), 'now' passed to
+ * the functions MUST never go backward. expired elements are removed lazily
+ * in 'xhash_ttl_get', or incrementally by 'xhash_ttl_expire'.
+ *
+ * the wheel links are stored behind the element data in the same node.
+ */
+
+#ifndef XHASH_TTL_WHEEL_BITS
+#define XHASH_TTL_WHEEL_BITS    8 // 256 slots per level
+#endif
+
+#ifndef XHASH_TTL_WHEEL_LEVELS
+#define XHASH_TTL_WHEEL_LEVELS  4 // covers 2^32 ticks, longer TTLs are re-queued
+#endif
+
+#define XHASH_TTL_WHEEL_SLOTS   (1 << XHASH_TTL_WHEEL_BITS)
+
+typedef struct xhash_ttl        xhash_ttl_t;
+typedef struct xhash_ttl_link   xhash_ttl_link_t;
+typedef struct xhash_ttl_meta   xhash_ttl_meta_t;
+
+/* called with an element before it's removed by expiring. */
+typedef void (*xhash_expire_cb)(void* pdata, void* ctx);
+
+struct xhash_ttl_link
+{
+    xhash_ttl_link_t*   prev;
+    xhash_ttl_link_t*   next;
+};
+
+struct xhash_ttl_meta
+{
+    xhash_ttl_link_t    link;
+    unsigned long long  expire;
+    unsigned            level;      // wheel level which 'link' is in, or
+                                    // 'XHASH_TTL_WHEEL_LEVELS' if it's in 'due'
+};
+
+struct xhash_ttl
+{
+    xhash_t             xh;
+    size_t              data_size;  // element data size without meta
+    size_t              meta_off;   // offset of meta, 'data_size' aligned
+    unsigned long long  clock;      // next tick to expire
+    xhash_expire_cb     expire_cb;
+    void*               expire_ctx;
+    size_t              counts[XHASH_TTL_WHEEL_LEVELS + 1]; // elements in each level
+    xhash_ttl_link_t    due;        // put with an expire tick before 'clock'
+    xhash_ttl_link_t    pending;    // cascading to lower levels
+    xhash_ttl_link_t*   wheel;      // slots of all levels
+};
+
+/* initialize a 'xhash_ttl_t', 'now' is the current tick.
+ * other arguments are the same as 'xhash_init'. */
+xhash_ttl_t* xhash_ttl_init(xhash_ttl_t* xt, int size, size_t data_size,
+            unsigned long long now, xhash_hash_cb hash_cb, xhash_equal_cb equal_cb,
+            xhash_destroy_cb destroy_cb);
+/* destroy a 'xhash_ttl_t' which has called 'xhash_ttl_init'. */
+void xhash_ttl_destroy(xhash_ttl_t* xt);
+
+/* allocate memory and initialize a 'xhash_ttl_t'. */
+xhash_ttl_t* xhash_ttl_new(int size, size_t data_size, unsigned long long now,
+            xhash_hash_cb hash_cb, xhash_equal_cb equal_cb, xhash_destroy_cb destroy_cb);
+/* release memory for a 'xhash_ttl_t' which 'xhash_ttl_new' returns. */
+void xhash_ttl_free(xhash_ttl_t* xt);
+
+/* set the callback called before an element is removed by expiring. */
+#define xhash_ttl_set_expire_cb(xt, cb, ctx) \
+                        ((xt)->expire_cb = (cb), (xt)->expire_ctx = (ctx))
+
+/* return the number of elements (including expired but not removed ones). */
+#define xhash_ttl_size(xt)      xhash_size(&(xt)->xh)
+/* check whether the container is empty. */
+#define xhash_ttl_empty(xt)     xhash_empty(&(xt)->xh)
+/* return an iterator to the beginning, the order is the same as 'xhash_t'. */
+#define xhash_ttl_begin(xt)     xhash_begin(&(xt)->xh)
+/* return an iterator to the end. */
+#define xhash_ttl_end(xt)       xhash_end(&(xt)->xh)
+/* return the next iterator of 'iter'. */
+#define xhash_ttl_iter_next(xt, iter) \
+                        xhash_iter_next(&(xt)->xh, iter)
+
+/* return the expire tick of 'iter', 'iter' MUST be valid. */
+#define xhash_ttl_iter_expire(xt, iter) \
+            ((xhash_ttl_meta_t*)((char*)xhash_iter_data(iter) + (xt)->meta_off))->expire
+
+/* insert an element with specific data which expires at tick 'expire', return
+ * an iterator to the inserted element, return 'NULL' when out of memory.
+ * if the data is already exist, update it's expire tick and return it. */
+#define xhash_ttl_put(xt, pdata, expire) \
+                        xhash_ttl_put_ex(xt, pdata, (xt)->data_size, expire)
+/* similar to 'xhash_ttl_put', but just init the <key> (which size is 'ksz'). */
+xhash_iter_t xhash_ttl_put_ex(xhash_ttl_t* xt, const void* pdata,
+            size_t ksz, unsigned long long expire);
+/* find an element with specific data, the element is removed if it has
+ * expired at 'now'. return an iterator to the element, 'NULL' if not found. */
+xhash_iter_t xhash_ttl_get(xhash_ttl_t* xt, const void* pdata, unsigned long long now);
+/* change the expire tick of 'iter', 'iter' MUST be valid. */
+void xhash_ttl_set_expire(xhash_ttl_t* xt, xhash_iter_t iter, unsigned long long expire);
+/* remove an element at 'iter', 'iter' MUST be valid. */
+void xhash_ttl_remove(xhash_ttl_t* xt, xhash_iter_t iter);
+/* remove elements which have expired at 'now'. at most 'budget' elements are
+ * touched (removed, or moved to a lower wheel level), the work is resumed by
+ * the next call. return the number of removed elements. */
+size_t xhash_ttl_expire(xhash_ttl_t* xt, unsigned long long now, size_t budget);
+/* check whether all elements expired at 'now' are removed by 'xhash_ttl_expire'. */
+#define xhash_ttl_expire_done(xt, now) \
+            ((xt)->clock > (now) && (xt)->due.next == &(xt)->due)
+/* remove all elements in 'xt'. */
+void xhash_ttl_clear(xhash_ttl_t* xt);
+
+#endif // _XHASH_TTL_H_
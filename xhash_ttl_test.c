@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "xhash_ttl.h"
+
+#define RAND_SEED 123456
+
+typedef struct
+{
+    int key;
+    int value;
+} kv_t;
+
+unsigned kv_hash(void* pdata)
+{
+    return xhash_improve_hash((unsigned)((kv_t*)pdata)->key);
+}
+int kv_equal(void* l, void* r)
+{
+    return ((kv_t*)l)->key == ((kv_t*)r)->key;
+}
+
+void on_expire(void* pdata, void* ctx)
+{
+    printf("expire key [%d]\n", ((kv_t*)pdata)->key);
+    ++*(int*)ctx;
+}
+
+void test()
+{
+    // time starts from tick 0
+    xhash_ttl_t* xt = xhash_ttl_new(-1, sizeof(kv_t), 0, kv_hash, kv_equal, NULL);
+    int expired = 0;
+    kv_t kv;
+    int i;
+
+    xhash_ttl_set_expire_cb(xt, on_expire, &expired);
+
+    // key i expires at tick (i + 1) * 100
+    for (i = 0; i < 10; ++i)
+    {
+        kv.key = i;
+        kv.value = i * 10;
+        xhash_ttl_put(xt, &kv, (i + 1) * 100);
+    }
+
+    // key 0 lives longer
+    kv.key = 0;
+    xhash_ttl_put(xt, &kv, 100000);
+
+    // key 1, 2 expire
+    while (!xhash_ttl_expire_done(xt, 300))
+        xhash_ttl_expire(xt, 300, 100);
+    // key 3 is removed lazily
+    kv.key = 3;
+    printf("key 3 %s\n", xhash_ttl_get(xt, &kv, 450) ? "found" : "not found");
+
+    printf("size %u, expired %d\n", (unsigned)xhash_ttl_size(xt), expired);
+
+    xhash_ttl_free(xt);
+}
+
+/* ------------------------------------- */
+// the expiring cache before 'xhash_ttl_t': scan all elements of 'xhash_t'.
+typedef struct
+{
+    int key;
+    int value;
+    unsigned long long expire;
+} kve_t;
+
+static double elapsed(struct timespec* b, struct timespec* e)
+{
+    return (e->tv_sec - b->tv_sec) + (e->tv_nsec - b->tv_nsec) / 1e9;
+}
+// xorshift32
+static inline unsigned rand_next(unsigned* s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 17;
+    *s ^= *s << 5;
+    return *s;
+}
+// 50% in [1, 1000), 30% in [1000, 60000), 20% in [60000, 3600000)
+static inline unsigned rand_ttl(unsigned* s)
+{
+    unsigned r = rand_next(s) % 10;
+
+    if (r < 5)
+        return 1 + rand_next(s) % 999;
+    if (r < 8)
+        return 1000 + rand_next(s) % 59000;
+    return 60000 + rand_next(s) % 3540000;
+}
+// insert 'nvalues' elements, then move time forward by 'step' ticks
+// and expire with 'budget' per call.
+void test_speed(int nvalues, int step, size_t budget)
+{
+    struct timespec begin, end, b, e;
+    xhash_ttl_t* xt;
+    xhash_t* xh;
+    xhash_iter_t iter, next;
+    unsigned long long now;
+    unsigned seed;
+    double t, max;
+    size_t n, total;
+    int calls, sweeps, i;
+    kve_t kve;
+    kv_t kv;
+
+    // xhash_ttl_t
+    xt = xhash_ttl_new(nvalues, sizeof(kv_t), 0, kv_hash, kv_equal, NULL);
+
+    seed = RAND_SEED;
+    timespec_get(&begin, TIME_UTC);
+    for (i = 0; i < nvalues; ++i)
+    {
+        kv.key = i;
+        kv.value = i;
+        xhash_ttl_put(xt, &kv, rand_ttl(&seed));
+    }
+    timespec_get(&end, TIME_UTC);
+    printf("[xhash_ttl_t] insert %d done, time %lfs.\n", nvalues, elapsed(&begin, &end));
+
+    total = 0;
+    calls = 0;
+    max = 0;
+    timespec_get(&begin, TIME_UTC);
+    for (now = step; !xhash_ttl_empty(xt); now += step)
+    {
+        do
+        {
+            timespec_get(&b, TIME_UTC);
+            n = xhash_ttl_expire(xt, now, budget);
+            timespec_get(&e, TIME_UTC);
+
+            t = elapsed(&b, &e);
+            if (t > max)
+                max = t;
+            total += n;
+            ++calls;
+        } while (!xhash_ttl_expire_done(xt, now));
+    }
+    timespec_get(&end, TIME_UTC);
+    printf("[xhash_ttl_t] expire %u done, time %lfs, %d calls, max %lfms per call.\n",
+        (unsigned)total, elapsed(&begin, &end), calls, max * 1000);
+
+    xhash_ttl_free(xt);
+
+    // xhash_t, full scan. too slow to run all sweeps, run the first ones.
+    xh = xhash_new(nvalues, sizeof(kve_t), kv_hash, kv_equal, NULL);
+
+    seed = RAND_SEED;
+    for (i = 0; i < nvalues; ++i)
+    {
+        kve.key = i;
+        kve.value = i;
+        kve.expire = rand_ttl(&seed);
+        xhash_put(xh, &kve);
+    }
+
+    total = 0;
+    sweeps = 0;
+    timespec_get(&begin, TIME_UTC);
+    for (now = step; sweeps < 20 && !xhash_empty(xh); now += step, ++sweeps)
+    {
+        for (iter = xhash_begin(xh); iter != xhash_end(xh); iter = next)
+        {
+            next = xhash_iter_next(xh, iter);
+            if (((kve_t*)xhash_iter_data(iter))->expire <= now)
+            {
+                xhash_remove(xh, iter);
+                ++total;
+            }
+        }
+    }
+    timespec_get(&end, TIME_UTC);
+    printf("[xhash_t scan] expire %u in %d sweeps, time %lfs, %lfms per sweep.\n",
+        (unsigned)total, sweeps, elapsed(&begin, &end),
+        elapsed(&begin, &end) * 1000 / sweeps);
+
+    xhash_free(xh);
+}
+
+/* ------------------------------------- */
+
+int main(int argc, char** argv)
+{
+    // test();
+    test_speed(10000000, 1000, 10000);
+    return 0;
+}
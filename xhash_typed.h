@@ -0,0 +1,309 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#ifndef _XHASH_TYPED_H_
+#define _XHASH_TYPED_H_
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "xhash.h"
+
+/*
+ * type-generating macro of hash table, the same logic as 'xhash_t', but
+ * keys and values are typed and 'hash_fn' / 'eq_fn' are called directly,
+ * so that the compiler can inline them (and fixed-size copies).
+ *
+ * XHASH_DECLARE(name, key_t, val_t, hash_fn, eq_fn) declares:
+ *   name_t, name_node_t (fields 'key' and 'value'), name_iter_t and
+ *   'static inline' functions name_init, name_destroy, name_new, name_free,
+ *   name_put, name_put_key, name_get, name_remove, name_clear, name_begin,
+ *   name_iter_next, the same semantics as 'xhash_*'. size, empty, end and
+ *   loadfactor are the shared 'xhash_typed_*' macros.
+ * 'hash_fn(key)' returns 'unsigned', 'eq_fn(key1, key2)' returns non-zero
+ * when the keys are equal, both take keys by value and can be macros. e.g.
+ *
+ *   #define int_eq(a, b) ((a) == (b))
+ *   XHASH_DECLARE(inthash, int, int, xhash_improve_hash, int_eq)
+ *
+ *   inthash_t* h = inthash_new(-1);
+ *   inthash_put(h, 1, 100);
+ *   inthash_iter_t iter = inthash_get(h, 1); // iter->value == 100
+ *
+ * there is no destroy callback, release the resource of keys (and values)
+ * before removing them.
+ */
+
+/* the same as the buckets of 'xhash_init', 'size' rounded up to 2^n. */
+static inline size_t xhash_typed_bkt_size(int size)
+{
+    unsigned z;
+
+    if (size < XHASH_DEFAULT_SIZE)
+        return XHASH_DEFAULT_SIZE;
+
+    z = (unsigned)size - 1;
+    z |= z >> 1;
+    z |= z >> 2;
+    z |= z >> 4;
+    z |= z >> 8;
+    z |= z >> 16;
+
+    return (size_t)z + 1;
+}
+
+#define XHASH_DECLARE(name, key_t, val_t, hash_fn, eq_fn)                   \
+                                                                            \
+typedef struct name##_node  name##_node_t;                                  \
+typedef struct name##_node* name##_iter_t;                                  \
+typedef struct name         name##_t;                                       \
+                                                                            \
+struct name##_node                                                          \
+{                                                                           \
+    name##_node_t*  prev;                                                   \
+    name##_node_t*  next;                                                   \
+    unsigned        hash;                                                   \
+    key_t           key;                                                    \
+    val_t           value;                                                  \
+};                                                                          \
+                                                                            \
+struct name                                                                 \
+{                                                                           \
+    size_t          bkt_size;                                               \
+    size_t          size;                                                   \
+    size_t          loadfactor;                                             \
+    name##_node_t** buckets;                                                \
+};                                                                          \
+                                                                            \
+static inline name##_t* name##_init(name##_t* h, int size)                  \
+{                                                                           \
+    h->bkt_size     = xhash_typed_bkt_size(size);                           \
+    h->size         = 0;                                                    \
+    h->loadfactor   = XHASH_DEFAULT_LOADFACTOR;                             \
+    h->buckets      = (name##_node_t**)calloc(h->bkt_size,                  \
+                        sizeof(name##_node_t*));                            \
+                                                                            \
+    return h->buckets ? h : NULL;                                           \
+}                                                                           \
+                                                                            \
+static inline void name##_clear(name##_t* h)                                \
+{                                                                           \
+    name##_node_t* iter;                                                    \
+    name##_node_t* next;                                                    \
+    size_t i;                                                               \
+                                                                            \
+    for (i = 0; h->size > 0 && i < h->bkt_size; ++i)                        \
+    {                                                                       \
+        for (iter = h->buckets[i]; iter; iter = next)                       \
+        {                                                                   \
+            next = iter->next;                                              \
+            free(iter);                                                     \
+            --h->size;                                                      \
+        }                                                                   \
+        h->buckets[i] = NULL;                                               \
+    }                                                                       \
+}                                                                           \
+                                                                            \
+static inline void name##_destroy(name##_t* h)                              \
+{                                                                           \
+    name##_clear(h);                                                        \
+    free(h->buckets);                                                       \
+}                                                                           \
+                                                                            \
+static inline name##_t* name##_new(int size)                                \
+{                                                                           \
+    name##_t* h = (name##_t*)malloc(sizeof(name##_t));                      \
+                                                                            \
+    if (h)                                                                  \
+    {                                                                       \
+        if (name##_init(h, size))                                           \
+            return h;                                                       \
+        free(h);                                                            \
+    }                                                                       \
+                                                                            \
+    return NULL;                                                            \
+}                                                                           \
+                                                                            \
+static inline void name##_free(name##_t* h)                                 \
+{                                                                           \
+    if (h)                                                                  \
+    {                                                                       \
+        name##_destroy(h);                                                  \
+        free(h);                                                            \
+    }                                                                       \
+}                                                                           \
+                                                                            \
+/* double the buckets, split every bucket into 'i' and 'i + bkt_size'. */   \
+static inline int name##_expand(name##_t* h)                                \
+{                                                                           \
+    size_t i;                                                               \
+    name##_node_t** new_bkts = (name##_node_t**)realloc(h->buckets,         \
+                        sizeof(name##_node_t*) * (h->bkt_size << 1));       \
+    name##_node_t* unlinked;                                                \
+    name##_node_t* iter;                                                    \
+                                                                            \
+    if (!new_bkts) return -1;                                               \
+                                                                            \
+    memset(&new_bkts[h->bkt_size], 0,                                       \
+            sizeof(name##_node_t*) * h->bkt_size);                          \
+                                                                            \
+    for (i = 0; i < h->bkt_size; ++i)                                       \
+    {                                                                       \
+        iter = new_bkts[i];                                                 \
+                                                                            \
+        while (iter)                                                        \
+        {                                                                   \
+            if (iter->hash & h->bkt_size)                                   \
+            {                                                               \
+                unlinked = iter;                                            \
+                iter = unlinked->next;                                      \
+                                                                            \
+                if (unlinked->next)                                         \
+                    unlinked->next->prev = unlinked->prev;                  \
+                if (unlinked->prev)                                         \
+                    unlinked->prev->next = iter;                            \
+                else                                                        \
+                    new_bkts[i] = iter;                                     \
+                                                                            \
+                unlinked->prev = NULL;                                      \
+                unlinked->next = new_bkts[i + h->bkt_size];                 \
+                                                                            \
+                if (unlinked->next)                                         \
+                    unlinked->next->prev = unlinked;                        \
+                                                                            \
+                new_bkts[i + h->bkt_size] = unlinked;                       \
+            }                                                               \
+            else                                                            \
+            {                                                               \
+                iter = iter->next;                                          \
+            }                                                               \
+        }                                                                   \
+    }                                                                       \
+                                                                            \
+    h->bkt_size <<= 1;                                                      \
+    h->buckets = new_bkts;                                                  \
+    return 0;                                                               \
+}                                                                           \
+                                                                            \
+/* insert 'key' if it's not exist, 'value' of the new element is not        \
+ * initialized. return an iterator to the element, 'NULL' when out of       \
+ * memory. */                                                               \
+static inline name##_iter_t name##_put_key(name##_t* h, key_t key)          \
+{                                                                           \
+    unsigned hash = hash_fn(key);                                           \
+    name##_node_t** bucket = &h->buckets[hash & (h->bkt_size - 1)];         \
+    name##_node_t* iter = *bucket;                                          \
+    name##_node_t* prev = NULL;                                             \
+                                                                            \
+    while (iter)                                                            \
+    {                                                                       \
+        if (hash == iter->hash && eq_fn(iter->key, key))                    \
+            return iter;                                                    \
+                                                                            \
+        prev = iter;                                                        \
+        iter = iter->next;                                                  \
+    }                                                                       \
+                                                                            \
+    iter = (name##_node_t*)malloc(sizeof(name##_node_t));                   \
+    if (!iter)                                                              \
+        return NULL;                                                        \
+                                                                            \
+    iter->key = key;                                                        \
+                                                                            \
+    if (prev)                                                               \
+        prev->next = iter;                                                  \
+    else                                                                    \
+        *bucket = iter;                                                     \
+                                                                            \
+    iter->prev = prev;                                                      \
+    iter->next = NULL;                                                      \
+    iter->hash = hash;                                                      \
+                                                                            \
+    if (++h->size * 100 > h->bkt_size * h->loadfactor)                      \
+        name##_expand(h);                                                   \
+                                                                            \
+    return iter;                                                            \
+}                                                                           \
+                                                                            \
+/* insert 'key' with 'value', if 'key' is already exist, do nothing         \
+ * and return it's iterator. */                                             \
+static inline name##_iter_t name##_put(name##_t* h, key_t key, val_t value) \
+{                                                                           \
+    size_t size = h->size;                                                  \
+    name##_node_t* iter = name##_put_key(h, key);                           \
+                                                                            \
+    if (iter && h->size != size)                                            \
+        iter->value = value;                                                \
+                                                                            \
+    return iter;                                                            \
+}                                                                           \
+                                                                            \
+static inline name##_iter_t name##_get(name##_t* h, key_t key)              \
+{                                                                           \
+    unsigned hash = hash_fn(key);                                           \
+    name##_node_t* iter = h->buckets[hash & (h->bkt_size - 1)];             \
+                                                                            \
+    while (iter)                                                            \
+    {                                                                       \
+        if (hash == iter->hash && eq_fn(iter->key, key))                    \
+            return iter;                                                    \
+                                                                            \
+        iter = iter->next;                                                  \
+    }                                                                       \
+                                                                            \
+    return NULL;                                                            \
+}                                                                           \
+                                                                            \
+static inline void name##_remove(name##_t* h, name##_iter_t iter)           \
+{                                                                           \
+    if (iter->prev)                                                         \
+        iter->prev->next = iter->next;                                      \
+    else                                                                    \
+        h->buckets[iter->hash & (h->bkt_size - 1)] = iter->next;            \
+                                                                            \
+    if (iter->next)                                                         \
+        iter->next->prev = iter->prev;                                      \
+                                                                            \
+    free(iter);                                                             \
+    --h->size;                                                              \
+}                                                                           \
+                                                                            \
+static inline name##_iter_t name##_begin(name##_t* h)                       \
+{                                                                           \
+    size_t i;                                                               \
+                                                                            \
+    for (i = 0; i < h->bkt_size; ++i)                                       \
+    {                                                                       \
+        if (h->buckets[i])                                                  \
+            return h->buckets[i];                                           \
+    }                                                                       \
+                                                                            \
+    return NULL;                                                            \
+}                                                                           \
+                                                                            \
+static inline name##_iter_t name##_iter_next(name##_t* h, name##_iter_t iter) \
+{                                                                           \
+    size_t i;                                                               \
+                                                                            \
+    if (iter->next)                                                         \
+        return iter->next;                                                  \
+                                                                            \
+    for (i = (iter->hash & (h->bkt_size - 1)) + 1; i < h->bkt_size; ++i)    \
+    {                                                                       \
+        if (h->buckets[i])                                                  \
+            return h->buckets[i];                                           \
+    }                                                                       \
+                                                                            \
+    return NULL;                                                            \
+}
+
+/* the same as the ones of 'xhash_t'. */
+#define xhash_typed_size(h)     ((h)->size)
+#define xhash_typed_empty(h)    ((h)->size == 0)
+#define xhash_typed_end(h)      NULL
+#define xhash_typed_set_loadfactor(h, factor) \
+                                (h)->loadfactor = factor
+
+#endif // _XHASH_TYPED_H_
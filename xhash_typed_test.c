@@ -0,0 +1,283 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "xhash_typed.h"
+
+#define RAND_SEED 123456
+
+/* int -> int */
+#define int_hash(k)         xhash_improve_hash((unsigned)(k))
+#define int_eq(a, b)        ((a) == (b))
+XHASH_DECLARE(inthash, int, int, int_hash, int_eq)
+
+/* uint64_t -> int */
+#define u64_hash(k)         ((unsigned)xhash_int_hash64(k, 0))
+#define u64_eq(a, b)        ((a) == (b))
+XHASH_DECLARE(u64hash, unsigned long long, int, u64_hash, u64_eq)
+
+/* short string (up to 15 chars, zero padded) -> int */
+typedef struct
+{
+    char s[16];
+} skey_t;
+
+#define skey_hash(k)        xhash_hash32((k).s, sizeof((k).s), 0)
+#define skey_eq(a, b)       (memcmp((a).s, (b).s, sizeof((a).s)) == 0)
+XHASH_DECLARE(strhash, skey_t, int, skey_hash, skey_eq)
+
+void test()
+{
+    inthash_t* h = inthash_new(-1);
+    inthash_iter_t iter;
+    int i;
+
+    for (i = 0; i < 20; ++i)
+        inthash_put(h, i, i * 10);
+
+    // already exist, the value doesn't change
+    inthash_put(h, 3, 0);
+
+    // remove the odd ones
+    for (i = 1; i < 20; i += 2)
+        inthash_remove(h, inthash_get(h, i));
+
+    // traverse
+    for (iter = inthash_begin(h);
+            iter != xhash_typed_end(h); iter = inthash_iter_next(h, iter))
+    {
+        printf("%d:%d ", iter->key, iter->value);
+    }
+    printf("\nsize %u\n", (unsigned)xhash_typed_size(h));
+
+    inthash_free(h);
+}
+
+/* ------------------------------------- */
+// the same keys and values with callbacks in 'xhash_t'
+typedef struct
+{
+    int key;
+    int value;
+} ikv_t;
+typedef struct
+{
+    unsigned long long key;
+    int value;
+} ukv_t;
+typedef struct
+{
+    skey_t key;
+    int value;
+} skv_t;
+
+unsigned ikv_hash(void* p) { return int_hash(((ikv_t*)p)->key); }
+int ikv_equal(void* l, void* r) { return ((ikv_t*)l)->key == ((ikv_t*)r)->key; }
+unsigned ukv_hash(void* p) { return u64_hash(((ukv_t*)p)->key); }
+int ukv_equal(void* l, void* r) { return ((ukv_t*)l)->key == ((ukv_t*)r)->key; }
+unsigned skv_hash(void* p) { return skey_hash(((skv_t*)p)->key); }
+int skv_equal(void* l, void* r) { return skey_eq(((skv_t*)l)->key, ((skv_t*)r)->key); }
+
+static double elapsed(struct timespec* b, struct timespec* e)
+{
+    return (e->tv_sec - b->tv_sec) + (e->tv_nsec - b->tv_nsec) / 1e9;
+}
+// xorshift32
+static inline unsigned rand_next(unsigned* s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 17;
+    *s ^= *s << 5;
+    return *s;
+}
+static inline unsigned long long rand_u64(unsigned* s)
+{
+    unsigned long long h = rand_next(s);
+    return h << 32 | rand_next(s);
+}
+static inline void rand_skey(unsigned* s, skey_t* k)
+{
+    int len = 4 + rand_next(s) % 12;
+    int i;
+
+    memset(k, 0, sizeof(skey_t));
+    for (i = 0; i < len; ++i)
+        k->s[i] = 'a' + rand_next(s) % 26;
+}
+
+static void report(const char* name, double put, double get, int nvalues, int found)
+{
+    printf("[%s] put %d, time %lfs, get %d, time %lfs, %.2lf Mops/s, found %d.\n",
+        name, nvalues, put, nvalues, get, nvalues / get / 1e6, found);
+}
+
+// 'nvalues' random puts, then get them all
+void test_speed(int nvalues)
+{
+    struct timespec b, e;
+    double put, get;
+    unsigned seed;
+    int found, i;
+
+    /* int */
+    {
+        inthash_t* th = inthash_new(-1);
+        xhash_t* xh = xhash_new(-1, sizeof(ikv_t), ikv_hash, ikv_equal, NULL);
+        ikv_t kv;
+
+        seed = RAND_SEED;
+        timespec_get(&b, TIME_UTC);
+        for (i = 0; i < nvalues; ++i)
+            inthash_put(th, (int)rand_next(&seed), i);
+        timespec_get(&e, TIME_UTC);
+        put = elapsed(&b, &e);
+
+        seed = RAND_SEED;
+        timespec_get(&b, TIME_UTC);
+        for (found = 0, i = 0; i < nvalues; ++i)
+            found += inthash_get(th, (int)rand_next(&seed)) != NULL;
+        timespec_get(&e, TIME_UTC);
+        get = elapsed(&b, &e);
+        report("typed int", put, get, nvalues, found);
+
+        seed = RAND_SEED;
+        timespec_get(&b, TIME_UTC);
+        for (i = 0; i < nvalues; ++i)
+        {
+            kv.key = (int)rand_next(&seed);
+            kv.value = i;
+            xhash_put(xh, &kv);
+        }
+        timespec_get(&e, TIME_UTC);
+        put = elapsed(&b, &e);
+
+        seed = RAND_SEED;
+        timespec_get(&b, TIME_UTC);
+        for (found = 0, i = 0; i < nvalues; ++i)
+        {
+            kv.key = (int)rand_next(&seed);
+            found += xhash_get(xh, &kv) != NULL;
+        }
+        timespec_get(&e, TIME_UTC);
+        get = elapsed(&b, &e);
+        report("xhash_t int", put, get, nvalues, found);
+
+        inthash_free(th);
+        xhash_free(xh);
+    }
+
+    /* uint64_t */
+    {
+        u64hash_t* th = u64hash_new(-1);
+        xhash_t* xh = xhash_new(-1, sizeof(ukv_t), ukv_hash, ukv_equal, NULL);
+        ukv_t kv;
+
+        seed = RAND_SEED;
+        timespec_get(&b, TIME_UTC);
+        for (i = 0; i < nvalues; ++i)
+            u64hash_put(th, rand_u64(&seed), i);
+        timespec_get(&e, TIME_UTC);
+        put = elapsed(&b, &e);
+
+        seed = RAND_SEED;
+        timespec_get(&b, TIME_UTC);
+        for (found = 0, i = 0; i < nvalues; ++i)
+            found += u64hash_get(th, rand_u64(&seed)) != NULL;
+        timespec_get(&e, TIME_UTC);
+        get = elapsed(&b, &e);
+        report("typed uint64", put, get, nvalues, found);
+
+        seed = RAND_SEED;
+        timespec_get(&b, TIME_UTC);
+        for (i = 0; i < nvalues; ++i)
+        {
+            kv.key = rand_u64(&seed);
+            kv.value = i;
+            xhash_put(xh, &kv);
+        }
+        timespec_get(&e, TIME_UTC);
+        put = elapsed(&b, &e);
+
+        seed = RAND_SEED;
+        timespec_get(&b, TIME_UTC);
+        for (found = 0, i = 0; i < nvalues; ++i)
+        {
+            kv.key = rand_u64(&seed);
+            found += xhash_get(xh, &kv) != NULL;
+        }
+        timespec_get(&e, TIME_UTC);
+        get = elapsed(&b, &e);
+        report("xhash_t uint64", put, get, nvalues, found);
+
+        u64hash_free(th);
+        xhash_free(xh);
+    }
+
+    /* short string */
+    {
+        strhash_t* th = strhash_new(-1);
+        xhash_t* xh = xhash_new(-1, sizeof(skv_t), skv_hash, skv_equal, NULL);
+        skey_t k;
+        skv_t kv;
+
+        seed = RAND_SEED;
+        timespec_get(&b, TIME_UTC);
+        for (i = 0; i < nvalues; ++i)
+        {
+            rand_skey(&seed, &k);
+            strhash_put(th, k, i);
+        }
+        timespec_get(&e, TIME_UTC);
+        put = elapsed(&b, &e);
+
+        seed = RAND_SEED;
+        timespec_get(&b, TIME_UTC);
+        for (found = 0, i = 0; i < nvalues; ++i)
+        {
+            rand_skey(&seed, &k);
+            found += strhash_get(th, k) != NULL;
+        }
+        timespec_get(&e, TIME_UTC);
+        get = elapsed(&b, &e);
+        report("typed string", put, get, nvalues, found);
+
+        seed = RAND_SEED;
+        timespec_get(&b, TIME_UTC);
+        for (i = 0; i < nvalues; ++i)
+        {
+            rand_skey(&seed, &kv.key);
+            kv.value = i;
+            xhash_put(xh, &kv);
+        }
+        timespec_get(&e, TIME_UTC);
+        put = elapsed(&b, &e);
+
+        seed = RAND_SEED;
+        timespec_get(&b, TIME_UTC);
+        for (found = 0, i = 0; i < nvalues; ++i)
+        {
+            rand_skey(&seed, &kv.key);
+            found += xhash_get(xh, &kv) != NULL;
+        }
+        timespec_get(&e, TIME_UTC);
+        get = elapsed(&b, &e);
+        report("xhash_t string", put, get, nvalues, found);
+
+        strhash_free(th);
+        xhash_free(xh);
+    }
+}
+
+/* ------------------------------------- */
+
+int main(int argc, char** argv)
+{
+    // test();
+    test_speed(5000000);
+    return 0;
+}
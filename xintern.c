@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "xintern.h"
+
+/* bytes of an interned string of length 'len' in the arena */
+#define ENTRY_SIZE(len) \
+            ((sizeof(xintern_hdr_t) + (len) + 1 + sizeof(unsigned) - 1) \
+                & ~(sizeof(unsigned) - 1))
+#define CHUNK_DATA(c)   ((char*)((c) + 1))
+
+static unsigned key_seeded_hash(void* pdata, unsigned long long seed)
+{
+    xintern_key_t* key = pdata;
+    return xhash_hash32(key->str, key->len, seed);
+}
+
+static unsigned key_hash(void* pdata)
+{
+    return key_seeded_hash(pdata, 0);
+}
+
+static int key_equal(void* l, void* r)
+{
+    xintern_key_t* kl = l;
+    xintern_key_t* kr = r;
+
+    return kl->len == kr->len && memcmp(kl->str, kr->str, kl->len) == 0;
+}
+
+static xintern_chunk_t* chunk_new(xintern_t* xi, size_t size)
+{
+    xintern_chunk_t* c = malloc(sizeof(xintern_chunk_t) + size);
+
+    if (c)
+    {
+        c->size = size;
+        xi->memory += sizeof(xintern_chunk_t) + size;
+    }
+
+    return c;
+}
+
+/* return space for 'sz' bytes in the arena, 'NULL' when out of memory. */
+static char* arena_alloc(xintern_t* xi, size_t sz)
+{
+    xintern_chunk_t* c;
+    char* p;
+
+    if (sz <= (size_t)(xi->end - xi->pos))
+    {
+        p = xi->pos;
+        xi->pos += sz;
+        return p;
+    }
+
+    /* a large one is put into its own chunk behind the first one,
+     * the free space of the first one is still used */
+    if (sz > XINTERN_CHUNK_SIZE / 4)
+    {
+        c = chunk_new(xi, sz);
+        if (!c)
+            return NULL;
+
+        if (xi->chunks)
+        {
+            c->next = xi->chunks->next;
+            xi->chunks->next = c;
+        }
+        else
+        {
+            c->next = NULL;
+            xi->chunks = c;
+            xi->pos = xi->end = CHUNK_DATA(c) + sz;
+        }
+
+        return CHUNK_DATA(c);
+    }
+
+    c = chunk_new(xi, XINTERN_CHUNK_SIZE);
+    if (!c)
+        return NULL;
+
+    c->next = xi->chunks;
+    xi->chunks = c;
+    xi->pos = CHUNK_DATA(c) + sz;
+    xi->end = CHUNK_DATA(c) + XINTERN_CHUNK_SIZE;
+
+    return CHUNK_DATA(c);
+}
+
+xintern_t* xintern_init(xintern_t* xi, int size)
+{
+    if (!xhash_init(&xi->xh, size, sizeof(xintern_key_t),
+            key_hash, key_equal, NULL))
+        return NULL;
+
+    /* the seed goes into the string hash */
+    xhash_set_seeded_hash(&xi->xh, key_seeded_hash);
+
+    xi->chunks = NULL;
+    xi->pos = NULL;
+    xi->end = NULL;
+    xi->memory = 0;
+
+    return xi;
+}
+
+void xintern_destroy(xintern_t* xi)
+{
+    xintern_clear(xi);
+    xhash_destroy(&xi->xh);
+}
+
+xintern_t* xintern_new(int size)
+{
+    xintern_t* xi = malloc(sizeof(xintern_t));
+
+    if (xi)
+    {
+        if (xintern_init(xi, size))
+            return xi;
+        free(xi);
+    }
+
+    return NULL;
+}
+
+void xintern_free(xintern_t* xi)
+{
+    if (xi)
+    {
+        xintern_destroy(xi);
+        free(xi);
+    }
+}
+
+const char* xintern_put(xintern_t* xi, const char* str, int size)
+{
+    xintern_key_t key;
+    xintern_hdr_t* hdr;
+    xhash_iter_t iter;
+    unsigned hash;
+
+    key.str = str;
+    key.len = size < 0 ? strlen(str) : (size_t)size;
+    hash = xhash_hash_of(&xi->xh, &key);
+    iter = xhash_get_hashed(&xi->xh, &key, hash);
+
+    if (iter)
+        return ((xintern_key_t*)xhash_iter_data(iter))->str;
+
+    hdr = (xintern_hdr_t*)arena_alloc(xi, ENTRY_SIZE(key.len));
+    if (!hdr)
+        return NULL;
+
+    hdr->len = (unsigned)key.len;
+    hdr->hash = hash;
+    memcpy(hdr + 1, str, key.len);
+    ((char*)(hdr + 1))[key.len] = '\0';
+
+    key.str = (const char*)(hdr + 1);
+
+    if (!xhash_put_hashed(&xi->xh, &key, hash))
+    {
+        /* give the space back if it's the last one of the first chunk */
+        if ((char*)hdr + ENTRY_SIZE(key.len) == xi->pos)
+            xi->pos = (char*)hdr;
+        return NULL;
+    }
+
+    return key.str;
+}
+
+const char* xintern_get(xintern_t* xi, const char* str, int size)
+{
+    xintern_key_t key;
+    xhash_iter_t iter;
+
+    key.str = str;
+    key.len = size < 0 ? strlen(str) : (size_t)size;
+    iter = xhash_get_hashed(&xi->xh, &key, xhash_hash_of(&xi->xh, &key));
+
+    return iter ? ((xintern_key_t*)xhash_iter_data(iter))->str : NULL;
+}
+
+void xintern_clear(xintern_t* xi)
+{
+    xintern_chunk_t* c;
+
+    while (xi->chunks)
+    {
+        c = xi->chunks;
+        xi->chunks = c->next;
+        free(c);
+    }
+
+    xhash_clear(&xi->xh);
+
+    xi->pos = NULL;
+    xi->end = NULL;
+    xi->memory = 0;
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#ifndef _XINTERN_H_
+#define _XINTERN_H_
+
+#include <stddef.h>
+
+#include "xhash.h"
+
+/*
+ * string interning table. every distinct string is copied once into an
+ * append-only arena (chunks of 'XINTERN_CHUNK_SIZE' bytes), the returned
+ * pointer is stable until 'xintern_clear' or 'xintern_destroy', so interned
+ * strings can be compared by pointer. the string is NUL-terminated, its
+ * length and hash code are stored in front of it ('xintern_len',
+ * 'xintern_hash').
+ *
+ * the strings are indexed by a 'xhash_t' of '{str, len}' elements, looking up
+ * an already interned string doesn't allocate memory.
+ */
+
+#ifndef XINTERN_CHUNK_SIZE
+#define XINTERN_CHUNK_SIZE      65536 // strings longer than 1/4 of it get their own chunk
+#endif
+
+typedef struct xintern          xintern_t;
+typedef struct xintern_key      xintern_key_t;
+typedef struct xintern_hdr      xintern_hdr_t;
+typedef struct xintern_chunk    xintern_chunk_t;
+
+/* element of the index. */
+struct xintern_key
+{
+    const char*         str;
+    size_t              len;
+};
+
+/* in front of every interned string. */
+struct xintern_hdr
+{
+    unsigned            len;
+    unsigned            hash;
+};
+
+struct xintern_chunk
+{
+    xintern_chunk_t*    next;
+    size_t              size;       // bytes of the data behind it
+};
+
+struct xintern
+{
+    xhash_t             xh;
+    xintern_chunk_t*    chunks;     // the first one is being filled
+    char*               pos;        // free space of the first chunk
+    char*               end;
+    size_t              memory;     // bytes of all chunks
+};
+
+/* initialize a 'xintern_t', 'size' is the same as 'xhash_init'. */
+xintern_t* xintern_init(xintern_t* xi, int size);
+/* destroy a 'xintern_t' which has called 'xintern_init'. */
+void xintern_destroy(xintern_t* xi);
+
+/* allocate memory and initialize a 'xintern_t'. */
+xintern_t* xintern_new(int size);
+/* release memory for a 'xintern_t' which 'xintern_new' returns. */
+void xintern_free(xintern_t* xi);
+
+/* return the number of distinct strings. */
+#define xintern_size(xi)        xhash_size(&(xi)->xh)
+/* return the bytes of the arena chunks (the index is not counted). */
+#define xintern_memory(xi)      ((xi)->memory)
+
+/* return the length of interned string 's'. */
+#define xintern_len(s)          (((const xintern_hdr_t*)(s) - 1)->len)
+/* return the hash code of interned string 's', the same as 'xhash_hash_of'
+ * of the index, can be used in 'xhash_hash_cb' of other tables. */
+#define xintern_hash(s)         (((const xintern_hdr_t*)(s) - 1)->hash)
+
+/* intern 'size' characters of 'str', 'size' < 0 means 'strlen(str)'.
+ * return the interned string, return 'NULL' when out of memory. */
+const char* xintern_put(xintern_t* xi, const char* str, int size);
+/* find 'size' characters of 'str', 'size' < 0 means 'strlen(str)'.
+ * return the interned string, return 'NULL' if it's not interned. */
+const char* xintern_get(xintern_t* xi, const char* str, int size);
+
+/* intern the characters of a 'xstr_t'. */
+#define xintern_put_str(xi, xs) \
+            xintern_put(xi, xstr_data(xs), (int)xstr_size(xs))
+/* find the characters of a 'xstr_t'. */
+#define xintern_get_str(xi, xs) \
+            xintern_get(xi, xstr_data(xs), (int)xstr_size(xs))
+
+/* remove all strings, the interned strings are invalid after that. */
+void xintern_clear(xintern_t* xi);
+
+#endif // _XINTERN_H_
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2019-2022 nonikon@qq.com.
+ * All rights reserved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "xintern.h"
+#include "xstring.h"
+
+#define RAND_SEED 123456
+
+void test()
+{
+    xintern_t* xi = xintern_new(-1);
+    const char* a = xintern_put(xi, "content-type", -1);
+    const char* b;
+    xstr_t xs;
+
+    xstr_init_with(&xs, "content-type: text/html", 12);
+    b = xintern_put_str(xi, &xs);
+
+    // the same string is interned once
+    printf("%s == %s: %d, len %u, hash %08x\n", a, b, a == b,
+        xintern_len(a), xintern_hash(a));
+
+    printf("get 'accept': %s\n", xintern_get(xi, "accept", -1) ? "found" : "not found");
+    xintern_put(xi, "accept", -1);
+    printf("get 'accept': %s\n", xintern_get(xi, "accept", -1) ? "found" : "not found");
+
+    printf("size %u, memory %u bytes\n",
+        (unsigned)xintern_size(xi), (unsigned)xintern_memory(xi));
+
+    xstr_destroy(&xs);
+    xintern_free(xi);
+}
+
+/* ------------------------------------- */
+
+static double elapsed(struct timespec* b, struct timespec* e)
+{
+    return (e->tv_sec - b->tv_sec) + (e->tv_nsec - b->tv_nsec) / 1e9;
+}
+// xorshift32
+static inline unsigned rand_next(unsigned* s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 17;
+    *s ^= *s << 5;
+    return *s;
+}
+// bytes malloc really takes (glibc on 64-bit: 8 bytes overhead, 16 aligned)
+static inline size_t malloc_size(size_t n)
+{
+    return n + 8 <= 32 ? 32 : (n + 8 + 15) & ~(size_t)15;
+}
+
+static unsigned cstr_hash(void* pdata)
+{
+    return xhash_string_hash(*(char**)pdata);
+}
+static int cstr_equal(void* l, void* r)
+{
+    return strcmp(*(char**)l, *(char**)r) == 0;
+}
+static void cstr_destroy(void* pdata)
+{
+    free(*(char**)pdata);
+}
+
+// intern 'nvalues' strings which are picked from 'nunique' distinct labels,
+// by hand ('xhash_t' of 'char*' and 'strdup') and by 'xintern_t'.
+void test_speed(int nvalues, int nunique)
+{
+    struct timespec b, e;
+    xhash_t* xh;
+    xintern_t* xi;
+    xhash_iter_t iter;
+    char buf[64];
+    char* s;
+    size_t total, bytes;
+    unsigned seed;
+    int len, i;
+
+    /* by hand: find it, or copy it and put the copy */
+    seed = RAND_SEED;
+    total = bytes = 0;
+    timespec_get(&b, TIME_UTC);
+    xh = xhash_new(-1, sizeof(char*), cstr_hash, cstr_equal, cstr_destroy);
+    for (i = 0; i < nvalues; ++i)
+    {
+        len = sprintf(buf, "label_value_%u", rand_next(&seed) % nunique);
+        s = buf;
+        iter = xhash_get(xh, &s);
+
+        if (!iter)
+        {
+            s = malloc(len + 1);
+            memcpy(s, buf, len + 1);
+            xhash_put(xh, &s);
+            bytes += malloc_size(len + 1);
+        }
+        total += len;
+    }
+    timespec_get(&e, TIME_UTC);
+
+    printf("[by hand] intern %d (%u distinct), %.2lf Mops/s, %.1lf bytes per "
+        "distinct string (%.1lf characters).\n", nvalues, (unsigned)xhash_size(xh),
+        nvalues / elapsed(&b, &e) / 1e6,
+        (double)(bytes + xhash_size(xh) * malloc_size(sizeof(xhash_node_t) + sizeof(char*))
+            + xh->bkt_size * sizeof(void*)) / xhash_size(xh),
+        (double)total / nvalues);
+    xhash_free(xh);
+
+    /* xintern_t */
+    seed = RAND_SEED;
+    timespec_get(&b, TIME_UTC);
+    xi = xintern_new(-1);
+    for (i = 0; i < nvalues; ++i)
+    {
+        len = sprintf(buf, "label_value_%u", rand_next(&seed) % nunique);
+        xintern_put(xi, buf, len);
+    }
+    timespec_get(&e, TIME_UTC);
+
+    printf("[xintern] intern %d (%u distinct), %.2lf Mops/s, %.1lf bytes per "
+        "distinct string (arena %.1lf).\n", nvalues, (unsigned)xintern_size(xi),
+        nvalues / elapsed(&b, &e) / 1e6,
+        (double)(xintern_memory(xi) + xintern_size(xi)
+            * malloc_size(sizeof(xhash_node_t) + sizeof(xintern_key_t))
+            + xi->xh.bkt_size * sizeof(void*)) / xintern_size(xi),
+        (double)xintern_memory(xi) / xintern_size(xi));
+
+    /* lookups of interned strings, no allocation */
+    seed = RAND_SEED;
+    timespec_get(&b, TIME_UTC);
+    for (total = 0, i = 0; i < nvalues; ++i)
+    {
+        len = sprintf(buf, "label_value_%u", rand_next(&seed) % nunique);
+        total += xintern_get(xi, buf, len) != NULL;
+    }
+    timespec_get(&e, TIME_UTC);
+
+    printf("[xintern] get %d, found %u, %.2lf Mops/s.\n", nvalues,
+        (unsigned)total, nvalues / elapsed(&b, &e) / 1e6);
+
+    xintern_free(xi);
+}
+
+/* ------------------------------------- */
+
+int main(int argc, char** argv)
+{
+    // test();
+    test_speed(10000000, 1000000);
+    return 0;
+}
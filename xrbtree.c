@@ -8,6 +8,15 @@
 
 #include "xrbtree.h"
 
+#if defined(__GNUC__)
+#define xrbt_prefetch(p)    __builtin_prefetch(p)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define xrbt_prefetch(p)    _mm_prefetch((const char*)(p), _MM_HINT_T0)
+#else
+#define xrbt_prefetch(p)    ((void)0)
+#endif
+
 /*
  * +++++ linux kernel rbtree interface - start +++++
  */
@@ -73,6 +82,33 @@ static inline void __rb_rotate_set_parents(xrbt_node_t *old, xrbt_node_t *new,
     __rb_change_child(old, new, parent, root);
 }
 
+#if XRBT_ENABLE_RANK
+#define rb_size(rb)         ((rb) ? (rb)->rb_size : 0)
+
+static inline void rb_augment_propagate(xrbt_node_t *rb, xrbt_node_t *stop)
+{
+    while (rb != stop) {
+        rb->rb_size = rb_size(rb->rb_left) + rb_size(rb->rb_right) + 1;
+        rb = rb_parent(rb);
+    }
+}
+
+static inline void rb_augment_copy(xrbt_node_t *old, xrbt_node_t *new)
+{
+    new->rb_size = old->rb_size;
+}
+
+static inline void rb_augment_rotate(xrbt_node_t *old, xrbt_node_t *new)
+{
+    new->rb_size = old->rb_size;
+    old->rb_size = rb_size(old->rb_left) + rb_size(old->rb_right) + 1;
+}
+#else
+#define rb_augment_propagate(rb, stop)  ((void)0)
+#define rb_augment_copy(old, new)       ((void)0)
+#define rb_augment_rotate(old, new)     ((void)0)
+#endif
+
 /*
  * Insert 'node' into 'rb_link', below 'parent'
  */
@@ -159,6 +195,7 @@ static inline void __rb_insert_color(xrbt_node_t *node, xrbt_node_t **root)
                 if (tmp)
                     rb_set_parent_color(tmp, parent, RB_BLACK);
                 rb_set_parent_color(parent, node, RB_RED);
+                rb_augment_rotate(parent, node);
                 parent = node;
                 tmp = node->rb_right;
             }
@@ -179,6 +216,7 @@ static inline void __rb_insert_color(xrbt_node_t *node, xrbt_node_t **root)
                 rb_set_parent_color(tmp, gparent,
                             RB_BLACK);
             __rb_rotate_set_parents(gparent, parent, root, RB_RED);
+            rb_augment_rotate(gparent, parent);
             break;
         } else {
             tmp = gparent->rb_left;
@@ -202,6 +240,7 @@ static inline void __rb_insert_color(xrbt_node_t *node, xrbt_node_t **root)
                     rb_set_parent_color(tmp, parent,
                                 RB_BLACK);
                 rb_set_parent_color(parent, node, RB_RED);
+                rb_augment_rotate(parent, node);
                 parent = node;
                 tmp = node->rb_left;
             }
@@ -212,6 +251,7 @@ static inline void __rb_insert_color(xrbt_node_t *node, xrbt_node_t **root)
             if (tmp)
                 rb_set_parent_color(tmp, gparent, RB_BLACK);
             __rb_rotate_set_parents(gparent, parent, root, RB_RED);
+            rb_augment_rotate(gparent, parent);
             break;
         }
     }
@@ -264,6 +304,8 @@ static inline xrbt_node_t *__rb_erase_node(xrbt_node_t *node, xrbt_node_t **root
              */
             parent = successor;
             child2 = successor->rb_right;
+
+            rb_augment_copy(node, successor);
         } else {
             /*
              * Case 3: node's successor is leftmost under
@@ -288,6 +330,9 @@ static inline xrbt_node_t *__rb_erase_node(xrbt_node_t *node, xrbt_node_t **root
             parent->rb_left = child2;
             successor->rb_right = child;
             rb_set_parent(child, successor);
+
+            rb_augment_copy(node, successor);
+            rb_augment_propagate(parent, successor);
         }
 
         tmp = node->rb_left;
@@ -310,6 +355,7 @@ static inline xrbt_node_t *__rb_erase_node(xrbt_node_t *node, xrbt_node_t **root
         tmp = successor;
     }
 
+    rb_augment_propagate(tmp, NULL);
     return rebalance;
 }
 
@@ -343,6 +389,7 @@ static inline void __rb_erase_color(xrbt_node_t *parent, xrbt_node_t **root)
                 rb_set_parent_color(tmp1, parent, RB_BLACK);
                 __rb_rotate_set_parents(parent, sibling, root,
                             RB_RED);
+                rb_augment_rotate(parent, sibling);
                 sibling = tmp1;
             }
             tmp1 = sibling->rb_right;
@@ -410,6 +457,7 @@ static inline void __rb_erase_color(xrbt_node_t *parent, xrbt_node_t **root)
                 if (tmp1)
                     rb_set_parent_color(tmp1, sibling,
                                 RB_BLACK);
+                rb_augment_rotate(sibling, tmp2);
                 tmp1 = sibling;
                 sibling = tmp2;
             }
@@ -433,6 +481,7 @@ static inline void __rb_erase_color(xrbt_node_t *parent, xrbt_node_t **root)
                 rb_set_parent(tmp2, parent);
             __rb_rotate_set_parents(parent, sibling, root,
                         RB_BLACK);
+            rb_augment_rotate(parent, sibling);
             break;
         } else {
             sibling = parent->rb_left;
@@ -444,6 +493,7 @@ static inline void __rb_erase_color(xrbt_node_t *parent, xrbt_node_t **root)
                 rb_set_parent_color(tmp1, parent, RB_BLACK);
                 __rb_rotate_set_parents(parent, sibling, root,
                             RB_RED);
+                rb_augment_rotate(parent, sibling);
                 sibling = tmp1;
             }
             tmp1 = sibling->rb_left;
@@ -471,6 +521,7 @@ static inline void __rb_erase_color(xrbt_node_t *parent, xrbt_node_t **root)
                 if (tmp1)
                     rb_set_parent_color(tmp1, sibling,
                                 RB_BLACK);
+                rb_augment_rotate(sibling, tmp2);
                 tmp1 = sibling;
                 sibling = tmp2;
             }
@@ -483,6 +534,7 @@ static inline void __rb_erase_color(xrbt_node_t *parent, xrbt_node_t **root)
                 rb_set_parent(tmp2, parent);
             __rb_rotate_set_parents(parent, sibling, root,
                         RB_BLACK);
+            rb_augment_rotate(parent, sibling);
             break;
         }
     }
@@ -492,6 +544,32 @@ static inline void __rb_erase_color(xrbt_node_t *parent, xrbt_node_t **root)
  * +++++ linux kernel rbtree interface - end +++++
  */
 
+/* nodes in the block of 'xrbt_build_sorted' are not freed one by one. */
+#define bulk_has(tr, node) \
+            ((size_t)(node) - (size_t)(tr)->bulk < (tr)->bulk_size)
+
+static inline void bulk_free(xrbt_t* tr)
+{
+    free(tr->bulk);
+    tr->bulk = NULL;
+    tr->bulk_size = 0;
+}
+
+static inline void release_node(xrbt_t* tr, xrbt_node_t* node)
+{
+    if (tr->destroy_cb)
+        tr->destroy_cb(xrbt_iter_data(node));
+
+    if (bulk_has(tr, node))
+        return;
+#if XRBT_ENABLE_CACHE
+    node->rb_right = tr->cache;
+    tr->cache = node;
+#else
+    free(node);
+#endif
+}
+
 xrbt_t* xrbt_init(xrbt_t* tr, size_t data_size,
             xrbt_compare_cb compare_cb, xrbt_destroy_cb destroy_cb)
 {
@@ -504,6 +582,10 @@ xrbt_t* xrbt_init(xrbt_t* tr, size_t data_size,
 #endif
     /* no check 'tr->root' null or not */
     tr->root        = NULL;
+    tr->leftmost    = NULL;
+    tr->rightmost   = NULL;
+    tr->bulk        = NULL;
+    tr->bulk_size   = 0;
 
     return tr;
 }
@@ -539,25 +621,11 @@ void xrbt_free(xrbt_t* tr)
     }
 }
 
-xrbt_iter_t xrbt_insert_ex(xrbt_t* tr, const void* pdata, size_t ksz)
+/* link a new node with 'pdata' at 'link' (a child of 'parent'). */
+static xrbt_iter_t insert_at(xrbt_t* tr, xrbt_node_t* parent,
+            xrbt_node_t** link, const void* pdata, size_t ksz)
 {
-    xrbt_iter_t* iter = &tr->root;
-    xrbt_node_t* parent = NULL;
     xrbt_node_t* nwnd;
-    int result;
-
-    while (*iter)
-    {
-        result = tr->compare_cb(xrbt_iter_data(*iter), (void*)pdata);
-        parent = *iter;
-
-        if (result > 0)
-            iter = &(*iter)->rb_right;
-        else if (result < 0)
-            iter = &(*iter)->rb_left;
-        else
-            return *iter;
-    }
 
 #if XRBT_ENABLE_CACHE
     if (tr->cache)
@@ -576,7 +644,20 @@ xrbt_iter_t xrbt_insert_ex(xrbt_t* tr, const void* pdata, size_t ksz)
 #endif
     memcpy(xrbt_iter_data(nwnd), pdata, ksz);
 
-    __rb_insert_node(nwnd, parent, iter);
+    __rb_insert_node(nwnd, parent, link);
+
+    if (!parent)
+        tr->leftmost = tr->rightmost = nwnd;
+    else if (link == &tr->leftmost->rb_left)
+        tr->leftmost = nwnd;
+    else if (link == &tr->rightmost->rb_right)
+        tr->rightmost = nwnd;
+
+#if XRBT_ENABLE_RANK
+    nwnd->rb_size = 1;
+    for (; parent; parent = rb_parent(parent))
+        ++parent->rb_size;
+#endif
     __rb_insert_color(nwnd, &tr->root);
 
     ++tr->size;
@@ -584,6 +665,84 @@ xrbt_iter_t xrbt_insert_ex(xrbt_t* tr, const void* pdata, size_t ksz)
     return nwnd;
 }
 
+xrbt_iter_t xrbt_insert_ex(xrbt_t* tr, const void* pdata, size_t ksz)
+{
+    xrbt_iter_t* iter = &tr->root;
+    xrbt_node_t* parent = NULL;
+    int result;
+
+    while (*iter)
+    {
+        result = tr->compare_cb(xrbt_iter_data(*iter), (void*)pdata);
+        parent = *iter;
+
+        if (result > 0)
+            iter = &(*iter)->rb_right;
+        else if (result < 0)
+            iter = &(*iter)->rb_left;
+        else
+            return *iter;
+    }
+
+    return insert_at(tr, parent, iter, pdata, ksz);
+}
+
+xrbt_iter_t xrbt_insert_hint_ex(xrbt_t* tr, xrbt_iter_t hint,
+            const void* pdata, size_t ksz)
+{
+    xrbt_node_t* near;
+    int result;
+
+    if (!hint)
+    {
+        /* after the last one */
+        if (!tr->rightmost)
+            return insert_at(tr, NULL, &tr->root, pdata, ksz);
+        if (tr->compare_cb(xrbt_iter_data(tr->rightmost), (void*)pdata) > 0)
+            return insert_at(tr, tr->rightmost, &tr->rightmost->rb_right,
+                        pdata, ksz);
+        return xrbt_insert_ex(tr, pdata, ksz);
+    }
+
+    result = tr->compare_cb(xrbt_iter_data(hint), (void*)pdata);
+
+    if (result < 0)
+    {
+        /* before 'hint', between the previous one and 'hint'. one of
+         * them has a free link on the side facing the other one. */
+        near = xrbt_riter_next(hint);
+        if (near)
+        {
+            result = tr->compare_cb(xrbt_iter_data(near), (void*)pdata);
+            if (result == 0)
+                return near;
+            if (result < 0)
+                return xrbt_insert_ex(tr, pdata, ksz);
+        }
+        if (!hint->rb_left)
+            return insert_at(tr, hint, &hint->rb_left, pdata, ksz);
+        return insert_at(tr, near, &near->rb_right, pdata, ksz);
+    }
+    else if (result > 0)
+    {
+        /* after 'hint' */
+        near = xrbt_iter_next(hint);
+        if (near)
+        {
+            result = tr->compare_cb(xrbt_iter_data(near), (void*)pdata);
+            if (result == 0)
+                return near;
+            if (result > 0)
+                return xrbt_insert_ex(tr, pdata, ksz);
+        }
+        if (!hint->rb_right)
+            return insert_at(tr, hint, &hint->rb_right, pdata, ksz);
+        return insert_at(tr, near, &near->rb_left, pdata, ksz);
+    }
+
+    return hint;
+}
+
 xrbt_iter_t xrbt_find(xrbt_t* tr, const void* pdata)
 {
     xrbt_iter_t iter = tr->root;
@@ -609,19 +768,16 @@ void xrbt_erase(xrbt_t* tr, xrbt_iter_t iter)
     xrbt_iter_t* root = &tr->root;
     xrbt_node_t* rebalance;
 
+    if (iter == tr->leftmost)
+        tr->leftmost = xrbt_iter_next(iter);
+    if (iter == tr->rightmost)
+        tr->rightmost = xrbt_riter_next(iter);
+
     rebalance = __rb_erase_node(iter, root);
     if (rebalance)
         __rb_erase_color(rebalance, root);
 
-    if (tr->destroy_cb)
-        tr->destroy_cb(xrbt_iter_data(iter));
-
-#if XRBT_ENABLE_CACHE
-    iter->rb_right = tr->cache;
-    tr->cache = iter;
-#else
-    free(iter);
-#endif
+    release_node(tr, iter);
 
     --tr->size;
 }
@@ -664,24 +820,18 @@ void xrbt_clear(xrbt_t* tr)
             parent = rb_parent(iter);
             if (tr->destroy_cb)
                 tr->destroy_cb(xrbt_iter_data(iter));
-            free(iter);
+            if (!bulk_has(tr, iter))
+                free(iter);
             iter = parent;
         }
     }
 
+    bulk_free(tr);
+
     tr->size = 0;
     tr->root = NULL;
-}
-
-xrbt_iter_t xrbt_begin(xrbt_t* tr)
-{
-    xrbt_iter_t iter = tr->root;
-
-    if (!iter) return NULL;
-
-    while (iter->rb_left)
-        iter = iter->rb_left;
-    return iter;
+    tr->leftmost = NULL;
+    tr->rightmost = NULL;
 }
 
 xrbt_iter_t xrbt_iter_next(xrbt_iter_t iter)
@@ -713,17 +863,6 @@ xrbt_iter_t xrbt_iter_next(xrbt_iter_t iter)
     return parent;
 }
 
-xrbt_iter_t xrbt_rbegin(xrbt_t* tr)
-{
-    xrbt_iter_t iter = tr->root;
-
-    if (!iter) return NULL;
-
-    while (iter->rb_right)
-        iter = iter->rb_right;
-    return iter;
-}
-
 xrbt_iter_t xrbt_riter_next(xrbt_iter_t iter)
 {
     xrbt_node_t* parent;
@@ -748,4 +887,368 @@ xrbt_iter_t xrbt_riter_next(xrbt_iter_t iter)
         iter = parent;
 
     return parent;
-}
\ No newline at end of file
+}
+
+xrbt_iter_t xrbt_lower_bound(xrbt_t* tr, const void* pdata)
+{
+    xrbt_iter_t iter = tr->root;
+    xrbt_iter_t found = NULL;
+
+    /* the greater ones are on the left side */
+    while (iter)
+    {
+        if (tr->compare_cb(xrbt_iter_data(iter), (void*)pdata) > 0)
+            iter = iter->rb_right;
+        else
+        {
+            found = iter;
+            iter = iter->rb_left;
+        }
+    }
+
+    return found;
+}
+
+xrbt_iter_t xrbt_upper_bound(xrbt_t* tr, const void* pdata)
+{
+    xrbt_iter_t iter = tr->root;
+    xrbt_iter_t found = NULL;
+
+    while (iter)
+    {
+        if (tr->compare_cb(xrbt_iter_data(iter), (void*)pdata) >= 0)
+            iter = iter->rb_right;
+        else
+        {
+            found = iter;
+            iter = iter->rb_left;
+        }
+    }
+
+    return found;
+}
+
+xrbt_iter_t xrbt_equal_range(xrbt_t* tr, const void* pdata, xrbt_iter_t* end)
+{
+    xrbt_iter_t iter = xrbt_find(tr, pdata);
+
+    /* elements are unique, 'end' is next to it */
+    if (iter)
+        *end = xrbt_iter_next(iter);
+    else
+        *end = xrbt_upper_bound(tr, pdata);
+
+    return iter;
+}
+
+size_t xrbt_range_foreach(xrbt_t* tr, const void* lo, const void* hi,
+            xrbt_foreach_cb cb, void* ctx)
+{
+    xrbt_iter_t iter = xrbt_lower_bound(tr, hi);
+    size_t n = 0;
+
+    while (iter && tr->compare_cb(xrbt_iter_data(iter), (void*)lo) >= 0)
+    {
+        cb(xrbt_iter_data(iter), ctx);
+        iter = xrbt_iter_next(iter);
+        ++n;
+    }
+
+    return n;
+}
+
+/* black nodes on a path of 'node' (down to a leaf). */
+static int black_height(xrbt_node_t* node)
+{
+    int h = 0;
+
+    for (; node; node = node->rb_left)
+        h += rb_is_black(node);
+    return h;
+}
+
+/* join 'l', 'node' and 'r' (in iteration order) into one tree, 'l' and 'r'
+ * are valid trees with black roots. 'node' is linked as a red node where the
+ * black height of one side matches the other side, then it's fixed up as an
+ * inserted node. return the new root. */
+static xrbt_node_t* join_tree(xrbt_node_t* l, xrbt_node_t* node, xrbt_node_t* r)
+{
+    xrbt_node_t* root;
+    xrbt_node_t* parent = NULL;
+    xrbt_node_t* c;
+    int hl = black_height(l);
+    int hr = black_height(r);
+
+    if (hl >= hr)
+    {
+        /* down the right side of 'l' to a black node (or leaf) of height 'hr' */
+        root = l;
+        for (c = l; c && (rb_is_red(c) || hl > hr); c = c->rb_right)
+        {
+            hl -= rb_is_black(c);
+            parent = c;
+        }
+        node->rb_left = c;
+        node->rb_right = r;
+        if (parent)
+            parent->rb_right = node;
+    }
+    else
+    {
+        root = r;
+        for (c = r; c && (rb_is_red(c) || hr > hl); c = c->rb_left)
+        {
+            hr -= rb_is_black(c);
+            parent = c;
+        }
+        node->rb_left = l;
+        node->rb_right = c;
+        if (parent)
+            parent->rb_left = node;
+    }
+
+    if (node->rb_left)
+        rb_set_parent(node->rb_left, node);
+    if (node->rb_right)
+        rb_set_parent(node->rb_right, node);
+    rb_set_parent_color(node, parent, RB_RED);
+    rb_augment_propagate(node, NULL);
+
+    if (!parent)
+        root = node;
+    __rb_insert_color(node, &root);
+
+    return root;
+}
+
+/* split the tree which contains 'node' into the elements before it ('*l')
+ * and after it ('*r'), 'node' is taken out. */
+static void split_tree(xrbt_node_t* node, xrbt_node_t** l, xrbt_node_t** r)
+{
+    xrbt_node_t* parent = rb_parent(node);
+    xrbt_node_t* child = node;
+    xrbt_node_t* gparent;
+    xrbt_node_t* sub;
+
+    *l = node->rb_left;
+    *r = node->rb_right;
+    if (*l)
+        rb_set_parent_color(*l, NULL, RB_BLACK);
+    if (*r)
+        rb_set_parent_color(*r, NULL, RB_BLACK);
+
+    /* every ancestor goes to one side, with its other subtree */
+    while (parent)
+    {
+        gparent = rb_parent(parent);
+
+        if (child == parent->rb_right)
+        {
+            sub = parent->rb_left;
+            if (sub)
+                rb_set_parent_color(sub, NULL, RB_BLACK);
+            *l = join_tree(sub, parent, *l);
+        }
+        else
+        {
+            sub = parent->rb_right;
+            if (sub)
+                rb_set_parent_color(sub, NULL, RB_BLACK);
+            *r = join_tree(*r, parent, sub);
+        }
+
+        child = parent;
+        parent = gparent;
+    }
+}
+
+/* release all nodes of a detached subtree, return the number of them. */
+static size_t release_tree(xrbt_t* tr, xrbt_node_t* node)
+{
+    xrbt_node_t* parent;
+    size_t n = 0;
+
+    while (node)
+    {
+        if (node->rb_left)
+        {
+            parent = node;
+            node = node->rb_left;
+            parent->rb_left = NULL;
+            /* the right side is visited next, load it while releasing
+             * the left side */
+            if (parent->rb_right)
+                xrbt_prefetch(parent->rb_right);
+        }
+        else if (node->rb_right)
+        {
+            parent = node;
+            node = node->rb_right;
+            parent->rb_right = NULL;
+        }
+        else
+        {
+            parent = rb_parent(node);
+            release_node(tr, node);
+            node = parent;
+            ++n;
+        }
+    }
+
+    return n;
+}
+
+size_t xrbt_erase_range(xrbt_t* tr, xrbt_iter_t first, xrbt_iter_t last)
+{
+    xrbt_node_t* l;
+    xrbt_node_t* m;
+    xrbt_node_t* r;
+    size_t n;
+
+    if (first == last)
+        return 0;
+
+    /* cut the tree at 'first' and 'last', release the middle part as a
+     * whole, then join the two sides. it rebalances O(log(n)) times for
+     * the whole range, instead of once for every erased node. */
+    split_tree(first, &l, &m);
+
+    if (last)
+    {
+        split_tree(last, &m, &r);
+        tr->root = join_tree(l, last, r);
+    }
+    else
+    {
+        tr->root = l;
+    }
+
+    n = release_tree(tr, m) + 1;
+    release_node(tr, first);
+
+    tr->size -= n;
+
+    /* the ends may be removed */
+    tr->leftmost = tr->rightmost = tr->root;
+    if (tr->root)
+    {
+        while (tr->leftmost->rb_left)
+            tr->leftmost = tr->leftmost->rb_left;
+        while (tr->rightmost->rb_right)
+            tr->rightmost = tr->rightmost->rb_right;
+    }
+
+    return n;
+}
+
+/* link nodes '[0, n)' of 'bulk' (in iteration order) into a balanced tree.
+ * the levels above 'red' are full and black, the nodes at level 'red' (the
+ * last one, if it's not full) are red, so every path has the same number of
+ * black nodes. */
+static xrbt_node_t* build_balanced(char* bulk, size_t node_size, size_t n,
+            xrbt_node_t* parent, int level, int red)
+{
+    xrbt_node_t* node;
+    size_t mid;
+
+    if (n == 0)
+        return NULL;
+
+    mid = n / 2;
+    node = (xrbt_node_t*)(bulk + node_size * mid);
+
+    rb_set_parent_color(node, parent, level >= red ? RB_RED : RB_BLACK);
+    node->rb_left = build_balanced(bulk, node_size, mid,
+                        node, level + 1, red);
+    node->rb_right = build_balanced(bulk + node_size * (mid + 1), node_size,
+                        n - mid - 1, node, level + 1, red);
+#if XRBT_ENABLE_RANK
+    node->rb_size = n;
+#endif
+
+    return node;
+}
+
+int xrbt_build_sorted(xrbt_t* tr, const void* data, size_t n)
+{
+    size_t node_size = (sizeof(xrbt_node_t) + tr->data_size + 7) & ~(size_t)7;
+    const char* p = data;
+    char* bulk;
+    size_t i;
+    int full;
+
+    if (tr->root)
+        return -1;
+
+    for (i = 1; i < n; ++i)
+        if (tr->compare_cb((void*)(p + tr->data_size * (i - 1)),
+                (void*)(p + tr->data_size * i)) <= 0)
+            return -1;
+
+    if (n == 0)
+        return 0;
+
+    bulk = malloc(node_size * n);
+    if (!bulk)
+        return -1;
+
+    for (i = 0; i < n; ++i)
+        memcpy(xrbt_iter_data((xrbt_node_t*)(bulk + node_size * i)),
+            p + tr->data_size * i, tr->data_size);
+
+    /* the number of full levels, floor(log2(n + 1)) */
+    for (full = 0; ((size_t)2 << full) - 1 <= n; ++full)
+        ;
+
+    /* the nodes removed before are in 'bulk', it's empty now */
+    bulk_free(tr);
+    tr->bulk = bulk;
+    tr->bulk_size = node_size * n;
+    tr->root = build_balanced(bulk, node_size, n, NULL, 0, full);
+    tr->leftmost = (xrbt_node_t*)bulk;
+    tr->rightmost = (xrbt_node_t*)(bulk + node_size * (n - 1));
+    tr->size = n;
+
+    return 0;
+}
+
+#if XRBT_ENABLE_RANK
+xrbt_iter_t xrbt_select(xrbt_t* tr, size_t k)
+{
+    xrbt_iter_t iter = tr->root;
+    size_t l;
+
+    while (iter)
+    {
+        l = rb_size(iter->rb_left);
+
+        if (k < l)
+            iter = iter->rb_left;
+        else if (k > l)
+        {
+            k -= l + 1;
+            iter = iter->rb_right;
+        }
+        else
+            break;
+    }
+
+    return iter;
+}
+
+size_t xrbt_rank(xrbt_t* tr, xrbt_iter_t iter)
+{
+    xrbt_node_t* parent;
+    size_t k = rb_size(iter->rb_left);
+
+    /* every ancestor on the left side is before 'iter', with its left subtree */
+    while ((parent = rb_parent(iter)))
+    {
+        if (iter == parent->rb_right)
+            k += rb_size(parent->rb_left) + 1;
+        iter = parent;
+    }
+
+    return k;
+}
+#endif
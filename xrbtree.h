@@ -21,6 +21,14 @@
 #define XRBT_ENABLE_CACHE   0
 #endif
 
+/* every node keeps the number of nodes in its subtree (one more 'size_t'),
+ * so that 'xrbt_select' and 'xrbt_rank' are O(log(n)). it's updated when
+ * rotating, the same as the augmented rbtree of linux kernel.
+ * define 'XRBT_ENABLE_RANK=1' to enable it. */
+#ifndef XRBT_ENABLE_RANK
+#define XRBT_ENABLE_RANK    0
+#endif
+
 #endif
 
 typedef struct xrbt         xrbt_t;
@@ -29,12 +37,16 @@ typedef struct xrbt_node*   xrbt_iter_t;
 
 typedef void (*xrbt_destroy_cb)(void* pdata);
 typedef int  (*xrbt_compare_cb)(void* l, void* r);
+typedef void (*xrbt_foreach_cb)(void* pdata, void* ctx);
 
 struct xrbt_node {
     /* parent and color. use 'size_t' instead of 'unsigned long' for compability. */
     size_t rb_parent_color;
     struct xrbt_node*   rb_right;
     struct xrbt_node*   rb_left;
+#if XRBT_ENABLE_RANK
+    size_t              rb_size;    // nodes in this subtree
+#endif
     // char data[0];
 };
 
@@ -47,6 +59,10 @@ struct xrbt {
     xrbt_node_t*    cache;
 #endif
     xrbt_node_t*    root;
+    xrbt_node_t*    leftmost;   // the beginning, 'NULL' when empty
+    xrbt_node_t*    rightmost;  // the reverse beginning
+    void*           bulk;       // nodes of 'xrbt_build_sorted', one allocation
+    size_t          bulk_size;  // bytes of 'bulk'
 };
 
 /* initialize a 'xrbt_t'.
@@ -77,12 +93,17 @@ void xrbt_cache_free(xrbt_t* tr);
 /* return a reverse iterator to the end.  */
 #define xrbt_rend(xh)       NULL
 
+/* elements are iterated from the greatest to the least by 'compare_cb'
+ * (the greater one is on the left side). the bounds below are defined by
+ * this order, '[xrbt_lower_bound, xrbt_upper_bound)' can be walked by
+ * 'xrbt_iter_next'. */
+
 /* return an iterator to the beginning. */
-xrbt_iter_t xrbt_begin(xrbt_t* tr);
+#define xrbt_begin(tr)      ((tr)->leftmost)
 /* return the next iterator of 'iter'. */
 xrbt_iter_t xrbt_iter_next(xrbt_iter_t iter);
 /* return a reverse iterator to the beginning. */
-xrbt_iter_t xrbt_rbegin(xrbt_t* tr);
+#define xrbt_rbegin(tr)     ((tr)->rightmost)
 /* return the next reverse iterator of 'iter'. */
 xrbt_iter_t xrbt_riter_next(xrbt_iter_t iter);
 
@@ -100,6 +121,16 @@ xrbt_iter_t xrbt_riter_next(xrbt_iter_t iter);
 /* similar to 'xrbt_insert', but useful when we don't want to init all 'data_size',
  * just init the <key> (which size is 'ksz'), and set <value> by yourself later. */
 xrbt_iter_t xrbt_insert_ex(xrbt_t* tr, const void* pdata, size_t ksz);
+/* similar to 'xrbt_insert', but the element is linked next to 'hint' without
+ * searching from the root when it belongs right before or after 'hint' (in
+ * iteration order), it's amortized O(1) then (the ancestors are counted up
+ * with 'XRBT_ENABLE_RANK'). 'hint' = 'NULL' means the end.
+ * otherwise it's the same as 'xrbt_insert'. */
+#define xrbt_insert_hint(tr, hint, pdata) \
+            xrbt_insert_hint_ex(tr, hint, pdata, (tr)->data_size)
+/* similar to 'xrbt_insert_hint', but only init the <key> (see 'xrbt_insert_ex'). */
+xrbt_iter_t xrbt_insert_hint_ex(xrbt_t* tr, xrbt_iter_t hint,
+            const void* pdata, size_t ksz);
 /* find an element with specific data. return an iterator to the element with specific data,
  * return 'NULL' if not found. */
 xrbt_iter_t xrbt_find(xrbt_t* tr, const void* pdata);
@@ -108,6 +139,44 @@ void xrbt_erase(xrbt_t* tr, xrbt_iter_t iter);
 /* remove all elements (no cache) in 'tr'. */
 void xrbt_clear(xrbt_t* tr);
 
+/* return an iterator to the first element which is not greater than 'pdata',
+ * return 'NULL' if not found. */
+xrbt_iter_t xrbt_lower_bound(xrbt_t* tr, const void* pdata);
+/* return an iterator to the first element which is less than 'pdata',
+ * return 'NULL' if not found. */
+xrbt_iter_t xrbt_upper_bound(xrbt_t* tr, const void* pdata);
+/* return an iterator to the element equal to 'pdata' ('NULL' if not found),
+ * '*end' is set to 'xrbt_upper_bound' of it. */
+xrbt_iter_t xrbt_equal_range(xrbt_t* tr, const void* pdata, xrbt_iter_t* end);
+/* call 'cb' with the elements which are not less than 'lo' and not greater
+ * than 'hi' (in iteration order, from 'hi' down to 'lo'). it costs
+ * O(log(n) + k) for 'k' elements in range. return the number of them. */
+size_t xrbt_range_foreach(xrbt_t* tr, const void* lo, const void* hi,
+            xrbt_foreach_cb cb, void* ctx);
+/* remove the elements in '[first, last)', 'last' can be 'NULL' (the end).
+ * the tree is split at 'first' and 'last' and the two sides are joined, so
+ * it rebalances O(log(n)) times for the whole range instead of once for
+ * every element. return the number of removed elements. */
+size_t xrbt_erase_range(xrbt_t* tr, xrbt_iter_t first, xrbt_iter_t last);
+
+/* build an empty 'tr' from 'n' elements of 'data' which are sorted in
+ * iteration order (from the greatest to the least, no duplicate). it costs
+ * O(n): the balanced tree is linked directly (the last level is red when
+ * it's not full), all nodes come from one allocation. the order is checked
+ * with n - 1 calls of 'compare_cb'. the memory of removed nodes is kept
+ * until 'tr' is cleared or destroyed.
+ * return 0 on success, -1 when 'tr' is not empty, 'data' is not sorted
+ * or out of memory. */
+int xrbt_build_sorted(xrbt_t* tr, const void* data, size_t n);
+
+#if XRBT_ENABLE_RANK
+/* return an iterator to the element at index 'k' (from 0, in iteration
+ * order), return 'NULL' if 'k' >= size. */
+xrbt_iter_t xrbt_select(xrbt_t* tr, size_t k);
+/* return the index of 'iter' (in iteration order), 'iter' MUST be valid. */
+size_t xrbt_rank(xrbt_t* tr, xrbt_iter_t iter);
+#endif
+
 /* find an element with specific data. return a pointer to the element
  * with specific data, return 'XRBT_INVALID_DATA' if not found.
  * the return value can call 'xrbt_data_iter' to get it's iterator. */
@@ -7,6 +7,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include "xbtree.h"
 #include "xrbtree.h"
 
 #define RAND_SEED 123456
@@ -110,7 +111,7 @@ void traverse2(xrbt_node_t* node, int depth, int acc[])
 void tree_overview(xrbt_t* rb)
 {
     // printf the number of nodes in every depth of rbtree
-    int acc[36] = { 0 };
+    int acc[64] = { 0 };
     int depth;
     printf("\tsize %u, ", (unsigned)xrbt_size(rb));
     if (rb->root)
@@ -186,9 +187,329 @@ void test_speed(int nvalues)
 }
 /*----------------------testspeed----------------------*/
 
+/* +++++++++++++++++++++testbtree++++++++++++++++++++++  */
+#define NS_PER_OP(b, e, n) \
+            ((double)((e) - (b)) / CLOCKS_PER_SEC * 1e9 / (n))
+
+// insert, search and remove 'nvalues' random integers by 'xrbt_t' and
+// 'xbtree_t', small sizes are repeated for 10M operations at least.
+void test_btree(int nvalues)
+{
+    xrbt_t rb;
+    xbtree_t bt;
+    clock_t ins, sch, rmv, t;
+    int rounds = (10000000 + nvalues - 1) / nvalues;
+    int value, count, r, i;
+    double total = (double)nvalues * rounds;
+
+    xrbt_init(&rb, sizeof(int), on_cmp2, NULL);
+    xbtree_init(&bt, sizeof(int), on_cmp2, NULL);
+
+    ins = sch = rmv = 0;
+    for (count = 0, r = 0; r < rounds; ++r)
+    {
+        srand(RAND_SEED + r);
+        t = clock();
+        for (i = 0; i < nvalues; ++i)
+        {
+            value = rand_int();
+            xrbt_insert(&rb, &value);
+        }
+        ins += clock() - t;
+
+        srand(RAND_SEED + r);
+        t = clock();
+        for (i = 0; i < nvalues; ++i)
+        {
+            value = rand_int();
+            count += xrbt_find(&rb, &value) != NULL;
+        }
+        sch += clock() - t;
+
+        srand(RAND_SEED + r);
+        t = clock();
+        for (i = 0; i < nvalues; ++i)
+        {
+            value = rand_int();
+            xrbt_iter_t iter = xrbt_find(&rb, &value);
+            if (iter)
+                xrbt_erase(&rb, iter);
+        }
+        rmv += clock() - t;
+    }
+    printf("[xrbt_t   %9d] insert %.1lfns, search %.1lfns, remove %.1lfns per op, %d found.\n",
+        nvalues, NS_PER_OP(0, ins, total), NS_PER_OP(0, sch, total),
+        NS_PER_OP(0, rmv, total), count);
+
+    ins = sch = rmv = 0;
+    for (count = 0, r = 0; r < rounds; ++r)
+    {
+        srand(RAND_SEED + r);
+        t = clock();
+        for (i = 0; i < nvalues; ++i)
+        {
+            value = rand_int();
+            xbtree_insert(&bt, &value);
+        }
+        ins += clock() - t;
+
+        srand(RAND_SEED + r);
+        t = clock();
+        for (i = 0; i < nvalues; ++i)
+        {
+            value = rand_int();
+            count += xbtree_iter_valid(xbtree_find(&bt, &value));
+        }
+        sch += clock() - t;
+
+        srand(RAND_SEED + r);
+        t = clock();
+        for (i = 0; i < nvalues; ++i)
+        {
+            value = rand_int();
+            xbtree_iter_t iter = xbtree_find(&bt, &value);
+            if (xbtree_iter_valid(iter))
+                xbtree_erase(&bt, iter);
+        }
+        rmv += clock() - t;
+    }
+    printf("[xbtree_t %9d] insert %.1lfns, search %.1lfns, remove %.1lfns per op, %d found.\n",
+        nvalues, NS_PER_OP(0, ins, total), NS_PER_OP(0, sch, total),
+        NS_PER_OP(0, rmv, total), count);
+
+    xbtree_destroy(&bt);
+    xrbt_destroy(&rb);
+}
+/*----------------------testbtree----------------------*/
+
+/* +++++++++++++++++++++testrange++++++++++++++++++++++  */
+static void on_range(void* pdata, void* ctx)
+{
+    *(long long*)ctx += *(int*)pdata;
+}
+
+// scan a window of 1/1000 keys by 'xrbt_range_foreach' and by walking from
+// 'xrbt_begin', then remove the half of smaller keys at once and one by one.
+void test_range(int nvalues)
+{
+    xrbt_t rb[2];
+    xrbt_iter_t iter, next;
+    clock_t t;
+    long long sum[2] = { 0, 0 };
+    int lo, hi, value, i;
+    size_t n;
+
+    for (i = 0; i < 2; ++i)
+    {
+        xrbt_init(&rb[i], sizeof(int), on_cmp2, NULL);
+        srand(RAND_SEED);
+        for (n = 0; n < (size_t)nvalues; ++n)
+        {
+            value = rand_int();
+            xrbt_insert(&rb[i], &value);
+        }
+    }
+
+    lo = 0x40000000;
+    hi = lo + 0x7fffffff / 1000;
+
+    t = clock();
+    n = xrbt_range_foreach(&rb[0], &lo, &hi, on_range, &sum[0]);
+    t = clock() - t;
+    printf("[xrbt_range_foreach] %u in range, %.3lfms.\n", (unsigned)n,
+        (double)t / CLOCKS_PER_SEC * 1e3);
+
+    t = clock();
+    for (iter = xrbt_begin(&rb[0]); iter; iter = xrbt_iter_next(iter))
+    {
+        value = *(int*)xrbt_iter_data(iter);
+        if (value >= lo && value <= hi)
+            sum[1] += value;
+    }
+    t = clock() - t;
+    printf("[walk from begin   ] %s, %.3lfms.\n", sum[0] == sum[1] ? "same" : "different",
+        (double)t / CLOCKS_PER_SEC * 1e3);
+
+    // the smaller keys are at the end
+    value = 0;
+    t = clock();
+    n = xrbt_erase_range(&rb[0], xrbt_upper_bound(&rb[0], &value), xrbt_end(&rb[0]));
+    t = clock() - t;
+    printf("[xrbt_erase_range  ] remove %u, %.1lfms.\n", (unsigned)n,
+        (double)t / CLOCKS_PER_SEC * 1e3);
+
+    t = clock();
+    for (iter = xrbt_upper_bound(&rb[1], &value); iter; iter = next)
+    {
+        next = xrbt_iter_next(iter);
+        xrbt_erase(&rb[1], iter);
+    }
+    t = clock() - t;
+    printf("[xrbt_erase        ] remove %u, %.1lfms.\n", (unsigned)n,
+        (double)t / CLOCKS_PER_SEC * 1e3);
+    tree_overview(&rb[0]);
+    tree_overview(&rb[1]);
+
+    for (i = 0; i < 2; ++i)
+        xrbt_destroy(&rb[i]);
+}
+/*----------------------testrange----------------------*/
+
+/* +++++++++++++++++++++testrank++++++++++++++++++++++  */
+#if XRBT_ENABLE_RANK
+// query the 1%, 2%, ..., 99% percentiles by 'xrbt_select' and by walking
+// from 'xrbt_begin', then the rank of the found elements.
+void test_rank(int nvalues)
+{
+    xrbt_t rb;
+    xrbt_iter_t iter;
+    clock_t t;
+    size_t k, i, rank = 0;
+    int value, p, same = 1;
+    int pct[100];
+
+    xrbt_init(&rb, sizeof(int), on_cmp2, NULL);
+    srand(RAND_SEED);
+    t = clock();
+    for (i = 0; i < (size_t)nvalues; ++i)
+    {
+        value = rand_int();
+        xrbt_insert(&rb, &value);
+    }
+    t = clock() - t;
+    printf("[insert     ] %d, %.1lfns per op.\n", nvalues,
+        (double)t / CLOCKS_PER_SEC * 1e9 / nvalues);
+
+    // the least one is at the end
+    t = clock();
+    for (p = 1; p < 100; ++p)
+    {
+        k = xrbt_size(&rb) - 1 - xrbt_size(&rb) * p / 100;
+        pct[p] = *(int*)xrbt_iter_data(xrbt_select(&rb, k));
+    }
+    t = clock() - t;
+    printf("[xrbt_select] 99 percentiles, %.3lfus.\n",
+        (double)t / CLOCKS_PER_SEC * 1e6);
+
+    t = clock();
+    for (p = 99, i = 0, iter = xrbt_begin(&rb); p > 0; ++i, iter = xrbt_iter_next(iter))
+    {
+        k = xrbt_size(&rb) - 1 - xrbt_size(&rb) * p / 100;
+        if (i == k)
+        {
+            same &= pct[p] == *(int*)xrbt_iter_data(iter);
+            --p;
+        }
+    }
+    t = clock() - t;
+    printf("[walk       ] 99 percentiles, %.3lfus, %s.\n",
+        (double)t / CLOCKS_PER_SEC * 1e6, same ? "same" : "different");
+
+    t = clock();
+    for (p = 1; p < 100; ++p)
+        rank += xrbt_rank(&rb, xrbt_find(&rb, &pct[p]));
+    t = clock() - t;
+    printf("[xrbt_rank  ] 99 elements, %.3lfus, sum %lu.\n",
+        (double)t / CLOCKS_PER_SEC * 1e6, (unsigned long)rank);
+
+    xrbt_destroy(&rb);
+}
+#endif
+/*----------------------testrank----------------------*/
+
+/* +++++++++++++++++++++testbuild++++++++++++++++++++++  */
+// load 'nvalues' sorted integers by 'xrbt_insert' and by 'xrbt_build_sorted'.
+void test_build(int nvalues)
+{
+    xrbt_t rb;
+    clock_t t;
+    int* values = malloc(sizeof(int) * nvalues);
+    int i, found;
+
+    // in iteration order, from the greatest
+    for (i = 0; i < nvalues; ++i)
+        values[i] = (nvalues - i) * 2;
+
+    xrbt_init(&rb, sizeof(int), on_cmp2, NULL);
+    t = clock();
+    for (i = 0; i < nvalues; ++i)
+        xrbt_insert(&rb, &values[i]);
+    t = clock() - t;
+    printf("[xrbt_insert      ] %d sorted, %.1lfms.\n", nvalues,
+        (double)t / CLOCKS_PER_SEC * 1e3);
+    tree_overview(&rb);
+    xrbt_clear(&rb);
+
+    t = clock();
+    if (xrbt_build_sorted(&rb, values, nvalues) != 0)
+        printf("build failed.\n");
+    t = clock() - t;
+    printf("[xrbt_build_sorted] %d sorted, %.1lfms.\n", nvalues,
+        (double)t / CLOCKS_PER_SEC * 1e3);
+    tree_overview(&rb);
+
+    for (found = 0, i = 0; i < nvalues; ++i)
+        found += xrbt_find(&rb, &values[i]) != NULL;
+    printf("\t%d found.\n", found);
+
+    xrbt_destroy(&rb);
+    free(values);
+}
+/*----------------------testbuild----------------------*/
+
+/* +++++++++++++++++++++testscheduler++++++++++++++++++++++  */
+// a timer queue of 'ntimers' timers: pop the earliest one ('xrbt_rbegin',
+// the least is at the end) and schedule a later one (the greatest, at the
+// beginning), 'nops' times. by 'xrbt_insert' with the earliest one found from
+// the root (as it was before 'rightmost' is cached), by 'xrbt_insert' and by
+// 'xrbt_insert_hint' with the beginning.
+void test_scheduler(int ntimers, int nops)
+{
+    static const char* names[] = { "walk + insert       ", "rbegin + insert     ", "rbegin + insert_hint" };
+    xrbt_t rb;
+    xrbt_iter_t iter;
+    clock_t t;
+    int deadline, mode, i;
+
+    for (mode = 0; mode < 3; ++mode)
+    {
+        xrbt_init(&rb, sizeof(int), on_cmp2, NULL);
+        for (deadline = 0; deadline < ntimers; ++deadline)
+            xrbt_insert(&rb, &deadline);
+
+        t = clock();
+        for (i = 0; i < nops; ++i, ++deadline)
+        {
+            if (mode == 0)
+                for (iter = rb.root; iter->rb_right; iter = iter->rb_right);
+            else
+                iter = xrbt_rbegin(&rb);
+            xrbt_erase(&rb, iter);
+
+            if (mode == 2)
+                xrbt_insert_hint(&rb, xrbt_begin(&rb), &deadline);
+            else
+                xrbt_insert(&rb, &deadline);
+        }
+        t = clock() - t;
+        printf("[%s] %d timers, %.1lfns per op.\n", names[mode], ntimers,
+            (double)t / CLOCKS_PER_SEC * 1e9 / nops);
+
+        xrbt_destroy(&rb);
+    }
+}
+/*----------------------testscheduler----------------------*/
+
 int main(int argc, char** argv)
 {
     // test();
+    // for (int n = 1000; n <= 100000000; n *= 10) test_btree(n);
+    // test_range(1000000);
+#if XRBT_ENABLE_RANK
+    // test_rank(10000000);
+#endif
+    // test_build(10000000);
+    // test_scheduler(1000000, 10000000);
     test_speed(5000000);
     return 0;
 }
\ No newline at end of file